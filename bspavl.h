@@ -19,13 +19,19 @@ before you include this file in *one* C file to create the implementation.
 You can #define BSP_AVL_STATIC before the #include to keep everything
 private to one compilation unit.
 
+#define BSP_AVL_SIZE in every file that includes this one to have each
+node keep the size of its subtree, which avlrank, avlselect and
+avlcount need.
+
 AVL(3)                     Library Functions Manual                     AVL(3)
 
 
 
 NAME
-       avlinit, avlcreate, avlinsert, avldelete, avllookup, avlnext, avlprev -
-       Balanced binary search tree routines
+       avlinit, avlcreate, avlinsert, avldelete, avllookup, avlnext, avlprev,
+       avlrange, avlbuild, avlflatten, avljoin, avlsplit, avlunion,
+       avlintersect, avldifference, avlrank, avlselect, avlcount - Balanced
+       binary search tree routines
 
 SYNOPSIS
        #include "spewavl.h"
@@ -37,10 +43,12 @@ SYNOPSIS
               Avl *c[2];
               Avl *p;
               int8_t b;
+              int n;        // with BSP_AVL_SIZE
        };
 
        struct Avltree {
               int (*cmp)(void*, void*);
+              void (*aug)(Avl*);
               Avl *root;
        };
 
@@ -51,6 +59,20 @@ SYNOPSIS
        Avl     *avllookup(Avltree *tree, Avl *key, int dir);
        Avl     *avlnext(Avl *n);
        Avl     *avlprev(Avl *n);
+       void     avlrange(Avltree *tree, Avl *lo, Avl *hi,
+                    void (*f)(Avl *n, int whole, void *aux), void *aux);
+       Avltree *avlbuild(Avltree *tree, Avl **nodes, int n);
+       int      avlflatten(Avltree *tree, Avl **nodes, int n);
+       Avltree *avljoin(Avltree *left, Avl *pivot, Avltree *right);
+       Avl     *avlsplit(Avltree *tree, Avl *key, Avltree *right);
+       Avltree *avlunion(Avltree *a, Avltree *b, Avltree *rest);
+       Avltree *avlintersect(Avltree *a, Avltree *b, Avltree *rest);
+       Avltree *avldifference(Avltree *a, Avltree *b, Avltree *rest);
+
+       // With BSP_AVL_SIZE
+       int      avlrank(Avltree *tree, Avl *key);
+       Avl     *avlselect(Avltree *tree, int i);
+       int      avlcount(Avltree *tree, Avl *lo, Avl *hi);
 
 
 DESCRIPTION
@@ -79,13 +101,66 @@ DESCRIPTION
        given key and returns the closest node less than the given  key,  equal
        to,  or  the closest node greater than the key depending on whether dir
        is less than, equal to, or greater than zero, respectively. If  dir  is
-       zero  and there is no matching key, it returns NULL.  Avldelete removes
+       zero  and there is no matching key, or if there is no node on the side
+       dir asks for, it returns NULL.  Avldelete removes
        the node matching the key from the tree and returns it. It returns NULL
-       if no matching key is found.
+       if no matching key is found.  Avlinsert and avldelete  rebalance  the
+       tree by walking back up the parent links p without recursing, so they
+       take time logarithmic in the size of the tree and constant stack.
 
        Avlnext  returns  the next Avl node in an in-order walk of the AVL tree
        and avlprev returns the previous node.
 
+       A tree can keep an aggregate of each subtree, such as the sum or the
+       largest of some value, in the structures holding its nodes.  Set aug
+       in the tree after avlinit to a function that recomputes the aggregate
+       of a node from its own value and the aggregates of its children in
+       c[0] and c[1], either of which may be NULL.  The routines call it on
+       every node whose subtree changes, children before parents, which
+       costs time logarithmic in the size of the tree for each insert or
+       delete.  Avlrange breaks the nodes ordered at or after lo and before
+       hi into a logarithmic number of pieces and calls f on each with aux,
+       with whole 0 for a single node n and 1 for the whole subtree under n.
+       The pieces come in no particular order.  Folding the value of single
+       nodes with the aggregate of whole subtrees gives the aggregate of the
+       range.
+
+       Avlbuild replaces the contents of tree with the n nodes in the array
+       nodes, which must be sorted in the order of the tree with no two
+       equal.  It links them into a tree as balanced as can be in time
+       linear in n, without calling the comparison function, and returns
+       tree.  Avlflatten stores pointers to the first n nodes of tree in
+       order in nodes and returns how many it stored, taking time linear in
+       that number.
+
+       Avljoin moves every node of right and then pivot into left, all the
+       nodes of left being ordered before pivot and pivot before all those
+       of right, and returns left.  Pivot may be NULL.  Avlsplit leaves in
+       tree the nodes ordered before key and moves those after it into
+       right, which takes the comparison and aug functions of tree.  It
+       returns the node equal to key, which is in neither, or NULL.  Both
+       take time logarithmic in the size of the trees and call the
+       comparison function only to find key.
+
+       Avlunion, avlintersect and avldifference leave in a the nodes whose
+       keys are in a or b, in a and b, or in a and not in b.  Where both
+       trees hold a key the node of a stays.  Avlunion moves the nodes of b
+       into a, leaving b empty, and avlintersect and avldifference leave b
+       as it was.  The nodes taken out of the result, the nodes of b whose
+       keys were in a for avlunion and the nodes of a that avlintersect or
+       avldifference removed, make up rest, unless it is NULL, which takes
+       the comparison and aug functions of a.  They return a.  Merging m
+       nodes with n others takes time proportional to m log(n/m + 1), plus
+       the number of nodes in rest.
+
+       When BSP_AVL_SIZE is defined each node keeps in n the number of nodes
+       in its subtree, itself included, and the following routines take time
+       logarithmic in the size of the tree.  Avlrank returns the number of
+       nodes in the tree ordered before key, which need not be in the tree.
+       Avlselect returns the node with i nodes before it, counting from 0,
+       or NULL if i is not less than the number of nodes.  Avlcount returns
+       the number of nodes ordered at or after lo and before hi.
+
 EXAMPLES
        Typical usage is to embed the Avl structure as the first  member  of  a
        structure  that  holds  data  to  be  stored  in the tree.  Then pass a
@@ -216,15 +291,21 @@ extern "C" {
 typedef struct Avl Avl;
 typedef struct Avltree Avltree;
 typedef int (*Avlcmp)(Avl*, Avl*);
+typedef void (*Avlaug)(Avl*);
+typedef void (*Avlvisit)(Avl*, int, void*);
 
 struct Avl {
 	Avl *c[2];
 	Avl *p;
 	int8_t b;
+#ifdef BSP_AVL_SIZE
+	int n;
+#endif
 };
 
 struct Avltree {
 	Avlcmp cmp;
+	Avlaug aug;
 	Avl *root;
 };
 
@@ -237,6 +318,19 @@ __BSP_AVL_SCOPE Avl *avlnext(Avl*);
 __BSP_AVL_SCOPE Avl *avlprev(Avl*);
 __BSP_AVL_SCOPE Avl *avlmin(Avltree*);
 __BSP_AVL_SCOPE Avl *avlmax(Avltree*);
+__BSP_AVL_SCOPE void avlrange(Avltree*, Avl*, Avl*, Avlvisit, void*);
+__BSP_AVL_SCOPE Avltree *avlbuild(Avltree*, Avl**, int);
+__BSP_AVL_SCOPE int avlflatten(Avltree*, Avl**, int);
+__BSP_AVL_SCOPE Avltree *avljoin(Avltree*, Avl*, Avltree*);
+__BSP_AVL_SCOPE Avl *avlsplit(Avltree*, Avl*, Avltree*);
+__BSP_AVL_SCOPE Avltree *avlunion(Avltree*, Avltree*, Avltree*);
+__BSP_AVL_SCOPE Avltree *avlintersect(Avltree*, Avltree*, Avltree*);
+__BSP_AVL_SCOPE Avltree *avldifference(Avltree*, Avltree*, Avltree*);
+#ifdef BSP_AVL_SIZE
+__BSP_AVL_SCOPE int avlrank(Avltree*, Avl*);
+__BSP_AVL_SCOPE Avl *avlselect(Avltree*, int);
+__BSP_AVL_SCOPE int avlcount(Avltree*, Avl*, Avl*);
+#endif
 
 #ifdef __cplusplus
 }
@@ -246,6 +340,16 @@ __BSP_AVL_SCOPE Avl *avlmax(Avltree*);
 
 #ifdef BSP_AVL_IMPLEMENTATION
 
+#ifdef BSP_AVL_SIZE
+#define AVLSIZE(q) ((q) == NULL ? 0 : (q)->n)
+#define AVLRESIZE(q) ((q)->n = AVLSIZE((q)->c[0]) + AVLSIZE((q)->c[1]) + 1)
+// Add d to the sizes of q and all above it.
+#define AVLGROW(q, d) do { Avl *__r; for(__r = (q); __r != NULL; __r = __r->p) __r->n += (d); } while(0)
+#else
+#define AVLRESIZE(q)
+#define AVLGROW(q, d)
+#endif
+
 __BSP_AVL_SCOPE
 Avltree*
 avlcreate(Avlcmp cmp)
@@ -257,6 +361,7 @@ avlcreate(Avlcmp cmp)
 		return NULL;
 
 	t->cmp = cmp;
+	t->aug = NULL;
 	t->root = NULL;
 	return t;
 }
@@ -269,6 +374,7 @@ avlinit(Avltree *t, Avlcmp cmp)
 		return NULL;
 
 	t->cmp = cmp;
+	t->aug = NULL;
 	t->root = NULL;
 	return t;
 }
@@ -299,214 +405,211 @@ avllookup(Avltree *t, Avl *k, int d)
 		}
 		return h;
 	}
-	return NULL;
+	return n;
 }
 
-static int insert(Avlcmp, Avl*, Avl**, Avl*, Avl**);
+static Avl *singlerot(Avltree*, int, Avl*);
+static Avl *doublerot(Avltree*, int, Avl*);
+static Avl *rotate(Avltree*, int, Avl*);
+static void detach(Avltree*, Avl*);
 
-__BSP_AVL_SCOPE
-Avl*
-avlinsert(Avltree *t, Avl *k)
+// Recompute the augmentation of q and all above it.
+static void
+augup(Avltree *t, Avl *q)
 {
-	Avl *old;
-
-	if(t == NULL)
-		return NULL;
-
-	old = NULL;
-	insert(t->cmp, NULL, &t->root, k, &old);
-	return old;
+	if(t->aug == NULL)
+		return;
+	for(; q != NULL; q = q->p)
+		(t->aug)(q);
 }
 
-static int insertfix(int, Avl**);
-
-static int
-insert(Avlcmp cmp, Avl *p, Avl **qp, Avl *k, Avl **oldp)
+// The link in the tree that points to n.
+static Avl**
+slot(Avltree *t, Avl *n)
 {
-	Avl *q;
-	int fix, c;
-
-	q = *qp;
-	if(q == NULL) {
-		k->c[0] = NULL;
-		k->c[1] = NULL;
-		k->b = 0;
-		k->p = p;
-		*qp = k;
-		return 1;
-	}
-
-	c = cmp(k, q);
-	if(c == 0) {
-		*oldp = q;
-		*k = *q;
-		if(q->c[0] != NULL)
-			q->c[0]->p = k;
-		if(q->c[1] != NULL)
-			q->c[1]->p = k;
-		*qp = k;
-		return 0;
-	}
-	c = c > 0 ? 1 : -1;
-	fix = insert(cmp, q, q->c + (c+1)/2, k, oldp);
-	if(fix)
-		return insertfix(c, qp);
-	return 0;
+	if(n->p == NULL)
+		return &t->root;
+	return n->p->c + (n->p->c[1] == n);
 }
 
-static Avl *singlerot(int, Avl*);
-static Avl *doublerot(int, Avl*);
+// Put k in the place of q, which leaves the tree.
+static void
+replace(Avltree *t, Avl *q, Avl *k)
+{
+	*slot(t, q) = k;
+	*k = *q;
+	if(k->c[0] != NULL)
+		k->c[0]->p = k;
+	if(k->c[1] != NULL)
+		k->c[1]->p = k;
+}
 
+/*
+ * Rebalance above q, whose subtree just grew one taller, and return 1
+ * if the whole tree grew.
+ */
 static int
-insertfix(int c, Avl **t)
+grown(Avltree *t, Avl *q)
 {
-	Avl *s;
+	Avl *p, **qp;
+	int c;
 
-	s = *t;
-	if(s->b == 0) {
-		s->b = c;
-		return 1;
-	}
-	if(s->b == -c) {
-		s->b = 0;
+	// Walk up while the subtree under p grew taller on side c.
+	for(; (p = q->p) != NULL; q = p) {
+		c = p->c[1] == q ? 1 : -1;
+		if(p->b == 0) {
+			p->b = c;
+			continue;
+		}
+		if(p->b == -c) {
+			p->b = 0;
+			return 0;
+		}
+		qp = slot(t, p);
+		if(q->b == c)
+			*qp = singlerot(t, c, p);
+		else
+			*qp = doublerot(t, c, p);
 		return 0;
 	}
-	if(s->c[(c+1)/2]->b == c)
-		s = singlerot(c, s);
-	else
-		s = doublerot(c, s);
-	*t = s;
-	return 0;
+	return 1;
 }
 
-static int delete(Avlcmp, Avl**, Avl*, Avl**);
-static int deletemin(Avl**, Avl**);
-static int deletefix(int, Avl**);
-
 __BSP_AVL_SCOPE
 Avl*
-avldelete(Avltree *t, Avl *k)
+avlinsert(Avltree *t, Avl *k)
 {
-	Avl *old;
+	Avl *p, *q, **qp;
+	int c;
 
 	if(t == NULL)
 		return NULL;
-	if(t->root == NULL)
-		return NULL;
-
-	old = NULL;
-	delete(t->cmp, &t->root, k, &old);
-	return old;
-}
 
-static int
-delete(Avlcmp cmp, Avl **qp, Avl *k, Avl **oldp)
-{
-	Avl *q, *e;
-	int c, fix;
-
-	q = *qp;
-	if(q == NULL)
-		return 0;
-
-	c = cmp(k, q);
-	c = c > 0 ? 1 : c < 0 ? -1: 0;
-	if(c == 0) {
-		*oldp = q;
-		if(q->c[1] == NULL) {
-			*qp = q->c[0];
-			if(*qp != NULL)
-				(*qp)->p = q->p;
-			return 1;
+	p = NULL;
+	qp = &t->root;
+	while((q = *qp) != NULL) {
+		c = (t->cmp)(k, q);
+		if(c == 0) {
+			replace(t, q, k);
+			augup(t, k);
+			return q;
 		}
-		fix = deletemin(q->c+1, &e);
-		*e = *q;
-		if(q->c[0] != NULL)
-			q->c[0]->p = e;
-		if(q->c[1] != NULL)
-			q->c[1]->p = e;
-		*qp = e;
-		if(fix)
-			return deletefix(-1, qp);
-		return 0;
+		p = q;
+		qp = q->c + (c > 0);
 	}
-	fix = delete(cmp, q->c + (c+1)/2, k, oldp);
-	if(fix)
-		return deletefix(-c, qp);
-	return 0;
+	k->c[0] = NULL;
+	k->c[1] = NULL;
+	k->b = 0;
+	k->p = p;
+	*qp = k;
+	AVLRESIZE(k);
+	AVLGROW(p, 1);
+	augup(t, k);
+	grown(t, k);
+	return NULL;
 }
 
-static int
-deletemin(Avl **qp, Avl **oldp)
+__BSP_AVL_SCOPE
+Avl*
+avldelete(Avltree *t, Avl *k)
 {
 	Avl *q;
-	int fix;
-
-	q = *qp;
-	if(q->c[0] == NULL) {
-		*oldp = q;
-		*qp = q->c[1];
-		if(*qp != NULL)
-			(*qp)->p = q->p;
-		return 1;
+	int c;
+
+	if(t == NULL)
+		return NULL;
+
+	q = t->root;
+	while(q != NULL) {
+		c = (t->cmp)(k, q);
+		if(c == 0)
+			break;
+		q = q->c[c > 0];
 	}
-	fix = deletemin(q->c, oldp);
-	if(fix)
-		return deletefix(1, qp);
-	return 0;
+	if(q == NULL)
+		return NULL;
+	detach(t, q);
+	return q;
 }
 
-static Avl *rotate(int, Avl*);
-
-static int
-deletefix(int c, Avl **t)
+// Take q out of the tree and rebalance.
+static void
+detach(Avltree *t, Avl *q)
 {
-	Avl *s;
-	int a;
+	Avl *p, *e, *s, **qp;
+	int c;
 
-	s = *t;
-	if(s->b == 0) {
-		s->b = c;
-		return 0;
-	}
-	if(s->b == -c) {
-		s->b = 0;
-		return 1;
+	// Unlink q, or the next node e when q has two children, and note
+	// the parent p whose subtree on side c got shorter.
+	if(q->c[1] == NULL) {
+		p = q->p;
+		c = p != NULL && p->c[1] == q ? 1 : -1;
+		AVLGROW(p, -1);
+		*slot(t, q) = q->c[0];
+		if(q->c[0] != NULL)
+			q->c[0]->p = p;
+		augup(t, p);
+	} else {
+		for(e = q->c[1]; e->c[0] != NULL; e = e->c[0])
+			;
+		p = e->p;
+		c = p == q ? 1 : -1;
+		AVLGROW(p, -1);
+		p->c[p == q] = e->c[1];
+		if(e->c[1] != NULL)
+			e->c[1]->p = p;
+		replace(t, q, e);
+		if(p == q)
+			p = e;
+		augup(t, p);
 	}
-	a = (c+1)/2;
-	if(s->c[a]->b == 0) {
-		s = rotate(c, s);
-		s->b = -c;
-		*t = s;
-		return 0;
+
+	while(p != NULL) {
+		if(p->b == 0) {
+			p->b = -c;
+			break;
+		}
+		if(p->b == c) {
+			p->b = 0;
+			q = p;
+		} else {
+			qp = slot(t, p);
+			s = p->c[c < 0];
+			if(s->b == 0) {
+				*qp = q = rotate(t, -c, p);
+				q->b = c;
+				break;
+			}
+			if(s->b == -c)
+				*qp = q = singlerot(t, -c, p);
+			else
+				*qp = q = doublerot(t, -c, p);
+		}
+		p = q->p;
+		if(p != NULL)
+			c = p->c[1] == q ? 1 : -1;
 	}
-	if(s->c[a]->b == c)
-		s = singlerot(c, s);
-	else
-		s = doublerot(c, s);
-	*t = s;
-	return 1;
 }
 
 static Avl*
-singlerot(int c, Avl *s)
+singlerot(Avltree *t, int c, Avl *s)
 {
 	s->b = 0;
-	s = rotate(c, s);
+	s = rotate(t, c, s);
 	s->b = 0;
 	return s;
 }
 
 static Avl*
-doublerot(int c, Avl *s)
+doublerot(Avltree *t, int c, Avl *s)
 {
 	Avl *r, *p;
 	int a;
 
 	a = (c+1)/2;
 	r = s->c[a];
-	s->c[a] = rotate(-c, s->c[a]);
-	p = rotate(c, s);
+	s->c[a] = rotate(t, -c, s->c[a]);
+	p = rotate(t, c, s);
 
 	if(p->b == c) {
 		s->b = -c;
@@ -521,7 +624,7 @@ doublerot(int c, Avl *s)
 }
 
 static Avl*
-rotate(int c, Avl *s)
+rotate(Avltree *t, int c, Avl *s)
 {
 	Avl *r, *n;
 	int a;
@@ -534,6 +637,12 @@ rotate(int c, Avl *s)
 	r->c[a^1] = s;
 	r->p = s->p;
 	s->p = r;
+	AVLRESIZE(s);
+	AVLRESIZE(r);
+	if(t->aug != NULL) {
+		(t->aug)(s);
+		(t->aug)(r);
+	}
 	return r;
 }
 
@@ -602,5 +711,533 @@ bottom(Avltree *t, int d)
 	return n;
 }
 
+__BSP_AVL_SCOPE
+void
+avlrange(Avltree *t, Avl *lo, Avl *hi, Avlvisit f, void *aux)
+{
+	Avl *q, *n;
+
+	// Go down to the first node in range, where the paths to lo and hi part.
+	q = t->root;
+	while(q != NULL) {
+		if((t->cmp)(q, lo) < 0)
+			q = q->c[1];
+		else if((t->cmp)(q, hi) >= 0)
+			q = q->c[0];
+		else
+			break;
+	}
+	if(q == NULL)
+		return;
+	f(q, 0, aux);
+
+	// Everything right of the path to lo is in range, and left of the path to hi.
+	for(n = q->c[0]; n != NULL;) {
+		if((t->cmp)(n, lo) < 0) {
+			n = n->c[1];
+			continue;
+		}
+		f(n, 0, aux);
+		if(n->c[1] != NULL)
+			f(n->c[1], 1, aux);
+		n = n->c[0];
+	}
+	for(n = q->c[1]; n != NULL;) {
+		if((t->cmp)(n, hi) >= 0) {
+			n = n->c[0];
+			continue;
+		}
+		f(n, 0, aux);
+		if(n->c[0] != NULL)
+			f(n->c[0], 1, aux);
+		n = n->c[1];
+	}
+}
+
+/*
+ * Link the middle of the n nodes under p with a tree of each half as
+ * its children and return it, setting *h to the height. The left half
+ * is never the smaller, so the balance is 0 or -1.
+ */
+static Avl*
+build(Avltree *t, Avl **nodes, int n, Avl *p, int *h)
+{
+	Avl *q;
+	int m, hl, hr;
+
+	if(n == 0) {
+		*h = 0;
+		return NULL;
+	}
+	m = n/2;
+	q = nodes[m];
+	q->p = p;
+	q->c[0] = build(t, nodes, m, q, &hl);
+	q->c[1] = build(t, nodes+m+1, n-m-1, q, &hr);
+	q->b = hr - hl;
+	*h = (hl > hr ? hl : hr) + 1;
+	AVLRESIZE(q);
+	if(t->aug != NULL)
+		(t->aug)(q);
+	return q;
+}
+
+__BSP_AVL_SCOPE
+Avltree*
+avlbuild(Avltree *t, Avl **nodes, int n)
+{
+	int h;
+
+	if(t == NULL)
+		return NULL;
+
+	t->root = build(t, nodes, n, NULL, &h);
+	return t;
+}
+
+__BSP_AVL_SCOPE
+int
+avlflatten(Avltree *t, Avl **nodes, int n)
+{
+	Avl *q;
+	int i;
+
+	i = 0;
+	for(q = avlmin(t); q != NULL && i < n; q = avlnext(q))
+		nodes[i++] = q;
+	return i;
+}
+
+/*
+ * The join based set operations follow Blelloch, Ferizovic and Sun.
+ * 2016. Just join for parallel ordered sets. SPAA '16, 253-264. The
+ * routines below work on bare subtrees whose heights they pass along,
+ * since the height of a child follows from that of its parent and its
+ * balance, and a tree only serves to carry cmp and aug.
+ */
+
+static int
+height(Avl *q)
+{
+	int h;
+
+	for(h = 0; q != NULL; h++)
+		q = q->c[q->b > 0];
+	return h;
+}
+
+#define LHEIGHT(q, h) ((h) - 1 - ((q)->b > 0))
+#define RHEIGHT(q, h) ((h) - 1 - ((q)->b < 0))
+
+/*
+ * Join l, k and r, of heights hl and hr, and set *h to the height of
+ * the result. If one is more than one taller, k goes on its inner
+ * spine at a subtree about as tall as the other, which grows the tree
+ * as an insert would, so this takes time in the difference of heights.
+ */
+static Avl*
+join3(Avltree *t, Avl *l, int hl, Avl *k, Avl *r, int hr, int *h)
+{
+	Avltree tt;
+	Avl *q, *p, *s, *x;
+	int d, hq, hs;
+
+	if(l != NULL)
+		l->p = NULL;
+	if(r != NULL)
+		r->p = NULL;
+	if(hl - hr <= 1 && hr - hl <= 1) {
+		k->c[0] = l;
+		k->c[1] = r;
+		k->p = NULL;
+		if(l != NULL)
+			l->p = k;
+		if(r != NULL)
+			r->p = k;
+		k->b = hr - hl;
+		*h = (hl > hr ? hl : hr) + 1;
+		AVLRESIZE(k);
+		if(t->aug != NULL)
+			(t->aug)(k);
+		return k;
+	}
+
+	// Go down side d of the taller tree q.
+	d = hl > hr;
+	q = d ? l : r;
+	hq = d ? hl : hr;
+	s = d ? r : l;
+	hs = d ? hr : hl;
+	tt = *t;
+	tt.root = q;
+	*h = hq;
+	p = NULL;
+	while(hq > hs + 1) {
+		hq -= q->b == (d ? -1 : 1) ? 2 : 1;
+		p = q;
+		q = q->c[d];
+	}
+	k->c[d^1] = q;
+	k->c[d] = s;
+	k->b = d ? hs - hq : hq - hs;
+	k->p = p;
+	p->c[d] = k;
+	if(q != NULL)
+		q->p = k;
+	if(s != NULL)
+		s->p = k;
+	for(x = k; x != NULL; x = x->p) {
+		AVLRESIZE(x);
+		if(t->aug != NULL)
+			(t->aug)(x);
+	}
+	*h += grown(&tt, k);
+	return tt.root;
+}
+
+// Join l and r with the last node of l in between.
+static Avl*
+join2(Avltree *t, Avl *l, Avl *r, int hr, int *h)
+{
+	Avltree tt;
+	Avl *k;
+
+	if(l == NULL) {
+		if(r != NULL)
+			r->p = NULL;
+		*h = hr;
+		return r;
+	}
+	l->p = NULL;
+	tt = *t;
+	tt.root = l;
+	for(k = l; k->c[1] != NULL; k = k->c[1])
+		;
+	detach(&tt, k);
+	return join3(t, tt.root, height(tt.root), k, r, hr, h);
+}
+
+/*
+ * Split q of height h into the nodes before k, *l, and those after,
+ * *r, with their heights, and return the node equal to k or NULL.
+ */
+static Avl*
+split(Avltree *t, Avl *q, int h, Avl *k, Avl **l, int *hl, Avl **r, int *hr)
+{
+	Avl *a, *z, *x, *m;
+	int ha, hz, hx, c;
+
+	if(q == NULL) {
+		*l = *r = NULL;
+		*hl = *hr = 0;
+		return NULL;
+	}
+	a = q->c[0];
+	ha = LHEIGHT(q, h);
+	z = q->c[1];
+	hz = RHEIGHT(q, h);
+	c = (t->cmp)(k, q);
+	if(c == 0) {
+		*l = a;
+		*hl = ha;
+		*r = z;
+		*hr = hz;
+		if(a != NULL)
+			a->p = NULL;
+		if(z != NULL)
+			z->p = NULL;
+		return q;
+	}
+	if(c < 0) {
+		m = split(t, a, ha, k, l, hl, &x, &hx);
+		*r = join3(t, x, hx, q, z, hz, hr);
+		return m;
+	}
+	m = split(t, z, hz, k, &x, &hx, r, hr);
+	*l = join3(t, a, ha, q, x, hx, hl);
+	return m;
+}
+
+/*
+ * The nodes the set operations take out, in order and linked through
+ * c[1], to be built into rest.
+ */
+typedef struct Avldrop Avldrop;
+struct Avldrop {
+	Avl *head;
+	Avl **tail;
+	int n;
+};
+
+static void
+dropnode(Avldrop *d, Avl *q)
+{
+	if(d == NULL)
+		return;
+	*d->tail = q;
+	d->tail = q->c + 1;
+	d->n++;
+}
+
+static void
+droptree(Avldrop *d, Avl *q)
+{
+	Avl *r;
+
+	if(d == NULL || q == NULL)
+		return;
+	droptree(d, q->c[0]);
+	r = q->c[1];
+	dropnode(d, q);
+	droptree(d, r);
+}
+
+// Like build, but taking the next n nodes off the list *l.
+static Avl*
+buildlist(Avltree *t, Avl **l, int n, Avl *p, int *h)
+{
+	Avl *q, *c;
+	int m, hl, hr;
+
+	if(n == 0) {
+		*h = 0;
+		return NULL;
+	}
+	m = n/2;
+	c = buildlist(t, l, m, NULL, &hl);
+	q = *l;
+	*l = q->c[1];
+	q->p = p;
+	q->c[0] = c;
+	if(c != NULL)
+		c->p = q;
+	q->c[1] = buildlist(t, l, n-m-1, q, &hr);
+	q->b = hr - hl;
+	*h = (hl > hr ? hl : hr) + 1;
+	AVLRESIZE(q);
+	if(t->aug != NULL)
+		(t->aug)(q);
+	return q;
+}
+
+static void
+droprest(Avltree *t, Avldrop *d, Avltree *rest)
+{
+	int h;
+
+	if(rest == NULL)
+		return;
+	rest->cmp = t->cmp;
+	rest->aug = t->aug;
+	rest->root = buildlist(t, &d->head, d->n, NULL, &h);
+}
+
+__BSP_AVL_SCOPE
+Avltree*
+avljoin(Avltree *l, Avl *k, Avltree *r)
+{
+	int hl, hr, h;
+
+	if(l == NULL || r == NULL)
+		return NULL;
+
+	hl = height(l->root);
+	hr = height(r->root);
+	if(k == NULL)
+		l->root = join2(l, l->root, r->root, hr, &h);
+	else
+		l->root = join3(l, l->root, hl, k, r->root, hr, &h);
+	r->root = NULL;
+	return l;
+}
+
+__BSP_AVL_SCOPE
+Avl*
+avlsplit(Avltree *t, Avl *k, Avltree *r)
+{
+	int hl, hr;
+
+	if(t == NULL || r == NULL)
+		return NULL;
+
+	r->cmp = t->cmp;
+	r->aug = t->aug;
+	return split(t, t->root, height(t->root), k, &t->root, &hl, &r->root, &hr);
+}
+
+// Split b by the root of a, take the union of each side and join them.
+static Avl*
+unionh(Avltree *t, Avl *a, int ha, Avl *b, int hb, Avldrop *d, int *h)
+{
+	Avl *al, *ar, *bl, *br, *l, *r, *m;
+	int hal, har, hbl, hbr, hl, hr;
+
+	if(a == NULL || b == NULL) {
+		if(a == NULL) {
+			a = b;
+			ha = hb;
+		}
+		if(a != NULL)
+			a->p = NULL;
+		*h = ha;
+		return a;
+	}
+	al = a->c[0];
+	hal = LHEIGHT(a, ha);
+	ar = a->c[1];
+	har = RHEIGHT(a, ha);
+	m = split(t, b, hb, a, &bl, &hbl, &br, &hbr);
+	l = unionh(t, al, hal, bl, hbl, d, &hl);
+	if(m != NULL)
+		dropnode(d, m);
+	r = unionh(t, ar, har, br, hbr, d, &hr);
+	return join3(t, l, hl, a, r, hr, h);
+}
+
+// Split a by the root of b, which stays as it is, and recur on each side.
+static Avl*
+interh(Avltree *t, Avl *a, int ha, Avl *b, Avldrop *d, int *h)
+{
+	Avl *al, *ar, *l, *r, *m;
+	int hal, har, hl, hr;
+
+	if(a == NULL || b == NULL) {
+		droptree(d, a);
+		*h = 0;
+		return NULL;
+	}
+	m = split(t, a, ha, b, &al, &hal, &ar, &har);
+	l = interh(t, al, hal, b->c[0], d, &hl);
+	r = interh(t, ar, har, b->c[1], d, &hr);
+	if(m != NULL)
+		return join3(t, l, hl, m, r, hr, h);
+	return join2(t, l, r, hr, h);
+}
+
+static Avl*
+diffh(Avltree *t, Avl *a, int ha, Avl *b, Avldrop *d, int *h)
+{
+	Avl *al, *ar, *l, *r, *m;
+	int hal, har, hl, hr;
+
+	if(a == NULL || b == NULL) {
+		if(a != NULL)
+			a->p = NULL;
+		*h = a == NULL ? 0 : ha;
+		return a;
+	}
+	m = split(t, a, ha, b, &al, &hal, &ar, &har);
+	l = diffh(t, al, hal, b->c[0], d, &hl);
+	if(m != NULL)
+		dropnode(d, m);
+	r = diffh(t, ar, har, b->c[1], d, &hr);
+	return join2(t, l, r, hr, h);
+}
+
+__BSP_AVL_SCOPE
+Avltree*
+avlunion(Avltree *a, Avltree *b, Avltree *rest)
+{
+	Avldrop d;
+	int h;
+
+	if(a == NULL || b == NULL)
+		return NULL;
+
+	d.tail = &d.head;
+	d.n = 0;
+	a->root = unionh(a, a->root, height(a->root), b->root, height(b->root), rest != NULL ? &d : NULL, &h);
+	b->root = NULL;
+	droprest(a, &d, rest);
+	return a;
+}
+
+__BSP_AVL_SCOPE
+Avltree*
+avlintersect(Avltree *a, Avltree *b, Avltree *rest)
+{
+	Avldrop d;
+	int h;
+
+	if(a == NULL || b == NULL)
+		return NULL;
+
+	d.tail = &d.head;
+	d.n = 0;
+	a->root = interh(a, a->root, height(a->root), b->root, rest != NULL ? &d : NULL, &h);
+	droprest(a, &d, rest);
+	return a;
+}
+
+__BSP_AVL_SCOPE
+Avltree*
+avldifference(Avltree *a, Avltree *b, Avltree *rest)
+{
+	Avldrop d;
+	int h;
+
+	if(a == NULL || b == NULL)
+		return NULL;
+
+	d.tail = &d.head;
+	d.n = 0;
+	a->root = diffh(a, a->root, height(a->root), b->root, rest != NULL ? &d : NULL, &h);
+	droprest(a, &d, rest);
+	return a;
+}
+
+#ifdef BSP_AVL_SIZE
+__BSP_AVL_SCOPE
+int
+avlrank(Avltree *t, Avl *k)
+{
+	Avl *q;
+	int r;
+
+	r = 0;
+	q = t->root;
+	while(q != NULL) {
+		if((t->cmp)(k, q) <= 0) {
+			q = q->c[0];
+			continue;
+		}
+		r += AVLSIZE(q->c[0]) + 1;
+		q = q->c[1];
+	}
+	return r;
+}
+
+__BSP_AVL_SCOPE
+Avl*
+avlselect(Avltree *t, int i)
+{
+	Avl *q;
+	int l;
+
+	q = t->root;
+	while(q != NULL) {
+		l = AVLSIZE(q->c[0]);
+		if(i == l)
+			return q;
+		if(i < l) {
+			q = q->c[0];
+			continue;
+		}
+		i -= l + 1;
+		q = q->c[1];
+	}
+	return NULL;
+}
+
+__BSP_AVL_SCOPE
+int
+avlcount(Avltree *t, Avl *lo, Avl *hi)
+{
+	int n;
+
+	n = avlrank(t, hi) - avlrank(t, lo);
+	return n > 0 ? n : 0;
+}
+#endif
 
 #endif // BSP_AVL_IMPLEMENTATION
@@ -0,0 +1,263 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is an implicit d-ary heap implementation with dependencies on an
+ANSI C compatible calloc and free routines.
+
+Do this:
+	#define BSP_DARYHEAP_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_DARYHEAP_IMPLEMENTATION
+#include "bspdaryheap.h"
+
+You can #define BSP_DARYHEAP_STATIC before the #include to keep everything
+private to one compilation unit. And #define BSP_DARYHEAP_CALLOC, and
+BSP_DARYHEAP_FREE to avoid using using calloc, and free. #define
+BSP_DARYHEAP_D to change the number of children of a node from the
+default of 4.
+
+The interface follows bspfibheap.h. Embed a Darynode as the first member
+of a structure, initialize a Daryheap with daryinit and a comparison
+function, and pass pointers to the Darynode member to the routines.
+
+	Daryheap *daryinit(Daryheap *heap, Darycmp cmp);
+	Daryheap *daryinitbuf(Daryheap *heap, Darycmp cmp, Darynode **arr, int cap);
+	Daryheap *daryfree(Daryheap *heap);
+	int       daryinsert(Daryheap *heap, Darynode *node);
+	void      darydeletemin(Daryheap *heap);
+	void      darydecreasekey(Daryheap *heap, Darynode *node);
+	void      darydelete(Daryheap *heap, Darynode *node);
+
+The nodes are kept in an array ordered as an implicit heap with the
+children of the node at i in slots d*i+1 through d*i+d, so they share a
+cache line or two. The pos member of each node is its slot in the
+array, which lets decrease-key and delete find the node in O(1) and
+then restore order in O(log_d n).
+
+The minimum element is kept in the min member of the heap, NULL when the
+heap is empty. Daryinsert grows the array as needed and returns -1 if
+that allocation fails. Daryinitbuf instead uses the caller's array of
+cap entries, in which case daryinsert only fails when the heap already
+holds cap nodes, and daryfree leaves the array alone.
+*/
+
+#ifdef BSP_DARYHEAP_STATIC
+#define __BSP_DARYHEAP_SCOPE static
+#else
+#define __BSP_DARYHEAP_SCOPE
+#endif
+
+#ifndef __BSP_DARYHEAP_H_INCLUDE
+#define __BSP_DARYHEAP_H_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Daryheap Daryheap;
+typedef struct Darynode Darynode;
+typedef int (*Darycmp)(Darynode*, Darynode*);
+
+struct Daryheap {
+	Darycmp cmp;
+	Darynode *min;
+	Darynode **arr;
+	int len;
+	int cap;
+	int arrfixed;
+};
+
+struct Darynode {
+	int pos;
+};
+
+__BSP_DARYHEAP_SCOPE Daryheap *daryinit(Daryheap*, Darycmp);
+__BSP_DARYHEAP_SCOPE Daryheap *daryinitbuf(Daryheap*, Darycmp, Darynode**, int);
+__BSP_DARYHEAP_SCOPE Daryheap *daryfree(Daryheap*);
+__BSP_DARYHEAP_SCOPE int       daryinsert(Daryheap*, Darynode*);
+__BSP_DARYHEAP_SCOPE void      darydeletemin(Daryheap*);
+__BSP_DARYHEAP_SCOPE void      darydecreasekey(Daryheap*, Darynode*);
+__BSP_DARYHEAP_SCOPE void      darydelete(Daryheap*, Darynode*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_DARYHEAP_H_INCLUDE
+
+#ifdef BSP_DARYHEAP_IMPLEMENTATION
+
+#ifndef BSP_DARYHEAP_CALLOC
+#include <stdlib.h>
+#define BSP_DARYHEAP_CALLOC calloc
+#endif
+
+#ifndef BSP_DARYHEAP_FREE
+#include <stdlib.h>
+#define BSP_DARYHEAP_FREE free
+#endif
+
+#ifndef BSP_DARYHEAP_D
+#define BSP_DARYHEAP_D 4
+#endif
+
+#include <string.h>
+
+__BSP_DARYHEAP_SCOPE
+Daryheap*
+daryinit(Daryheap *h, Darycmp cmp)
+{
+	h->cmp = cmp;
+	h->min = NULL;
+	h->arr = NULL;
+	h->len = 0;
+	h->cap = 0;
+	h->arrfixed = 0;
+	return h;
+}
+
+__BSP_DARYHEAP_SCOPE
+Daryheap*
+daryinitbuf(Daryheap *h, Darycmp cmp, Darynode **arr, int cap)
+{
+	h->cmp = cmp;
+	h->min = NULL;
+	h->arr = arr;
+	h->len = 0;
+	h->cap = cap;
+	h->arrfixed = 1;
+	return h;
+}
+
+__BSP_DARYHEAP_SCOPE
+Daryheap*
+daryfree(Daryheap *h)
+{
+	if(!h->arrfixed) BSP_DARYHEAP_FREE(h->arr);
+	h->arr = NULL;
+	h->min = NULL;
+	h->len = 0;
+	h->cap = 0;
+	return h;
+}
+
+static int
+grow(Daryheap *h)
+{
+	Darynode **a;
+	int cap;
+
+	if(h->arrfixed) return -1;
+	cap = 2*h->cap + 16;
+	a = BSP_DARYHEAP_CALLOC(cap, sizeof(*a));
+	if(a == NULL) return -1;
+	memcpy(a, h->arr, h->len*sizeof(*a));
+	BSP_DARYHEAP_FREE(h->arr);
+	h->arr = a;
+	h->cap = cap;
+	return 0;
+}
+
+static void
+siftup(Daryheap *h, Darynode *n, int i)
+{
+	Darynode *p;
+	int pi;
+
+	while(i > 0) {
+		pi = (i-1) / BSP_DARYHEAP_D;
+		p = h->arr[pi];
+		if(h->cmp(n, p) >= 0) break;
+		h->arr[i] = p;
+		p->pos = i;
+		i = pi;
+	}
+	h->arr[i] = n;
+	n->pos = i;
+}
+
+static void
+siftdown(Daryheap *h, Darynode *n, int i)
+{
+	Darynode *c, *m;
+	int ci, mi, end;
+
+	for(;;) {
+		ci = BSP_DARYHEAP_D*i + 1;
+		if(ci >= h->len) break;
+		end = ci + BSP_DARYHEAP_D;
+		if(end > h->len) end = h->len;
+		mi = ci;
+		m = h->arr[ci];
+		for(ci++; ci < end; ci++) {
+			c = h->arr[ci];
+			if(h->cmp(c, m) < 0) {
+				m = c;
+				mi = ci;
+			}
+		}
+		if(h->cmp(m, n) >= 0) break;
+		h->arr[i] = m;
+		m->pos = i;
+		i = mi;
+	}
+	h->arr[i] = n;
+	n->pos = i;
+}
+
+__BSP_DARYHEAP_SCOPE
+int
+daryinsert(Daryheap *h, Darynode *n)
+{
+	if(h->len == h->cap && grow(h) == -1) return -1;
+	siftup(h, n, h->len++);
+	h->min = h->arr[0];
+	return 0;
+}
+
+static void
+remove1(Daryheap *h, int i)
+{
+	Darynode *last;
+
+	last = h->arr[--h->len];
+	if(i < h->len) {
+		if(i > 0 && h->cmp(last, h->arr[(i-1) / BSP_DARYHEAP_D]) < 0)
+			siftup(h, last, i);
+		else
+			siftdown(h, last, i);
+	}
+	h->min = h->len > 0 ? h->arr[0] : NULL;
+}
+
+__BSP_DARYHEAP_SCOPE
+void
+darydeletemin(Daryheap *h)
+{
+	if(h->len == 0) return;
+	remove1(h, 0);
+}
+
+__BSP_DARYHEAP_SCOPE
+void
+darydecreasekey(Daryheap *h, Darynode *n)
+{
+	siftup(h, n, n->pos);
+	h->min = h->arr[0];
+}
+
+__BSP_DARYHEAP_SCOPE
+void
+darydelete(Daryheap *h, Darynode *n)
+{
+	remove1(h, n->pos);
+}
+
+#endif // BSP_DARYHEAP_IMPLEMENTATION
@@ -21,14 +21,20 @@ You can #define BSP_FIBHEAP_STATIC before the #include to keep everything
 private to one compilation unit. And #define BSP_FIBHEAP_CALLOC, and
 BSP_FIBHEAP_FREE to avoid using using calloc, and free.
 
+#define BSP_FIBHEAP_STATS in every file that includes this one to have
+each heap count comparisons, links, cuts, cascading cut depths, root
+list lengths and consolidation array growth. Fibstats returns the
+counters, or NULL when they are compiled out.
+
 
 FIBHEAP(3)                 Library Functions Manual                 FIBHEAP(3)
 
 
 
 NAME
-       fibinit  fibcreate  fibfree  fibinsert fibdeletemin fibdecreasekey fib-
-       delete - Fibonacci heap routines
+       fibinit fibinitbuf fibarrlen fibcreate fibfree fibsetstep fibinsert
+       fibinsertmany fibdeletemin fibpopmany fibdecreasekey fibupdatekey
+       fibdelete - Fibonacci heap routines
 
 SYNOPSIS
        typedef struct Fibheap Fibheap;
@@ -40,6 +46,9 @@ SYNOPSIS
               Fibcmp cmp;
               Fibnode **arr;
               int arrlen;
+              int arrfixed;
+              Fibnode *pend;
+              int step;
        };
 
        struct Fibnode {
@@ -49,11 +58,17 @@ SYNOPSIS
        };
 
        Fibheap* fibinit(Fibheap *heap, Fibcmp cmp);
+       Fibheap* fibinitbuf(Fibheap *heap, Fibcmp cmp, Fibnode **arr, int arrlen);
+       int      fibarrlen(unsigned long n);
        Fibheap *fibcreate(Fibcmp cmp);
        Fibheap *fibfree(Fibheap *heap);
+       void     fibsetstep(Fibheap *heap, int step);
        void     fibinsert(Fibheap *heap, Fibnode *node);
+       void     fibinsertmany(Fibheap *heap, Fibnode **nodes, int n);
        int      fibdeletemin(Fibheap *node);
+       int      fibpopmany(Fibheap *heap, Fibnode **out, int k);
        void     fibdecreasekey(Fibheap *heap, Fibnode *node);
+       void     fibupdatekey(Fibheap *heap, Fibnode *node);
        int      fibdelete(Fibheap *heap, Fibnode *node);
 
 
@@ -79,16 +94,50 @@ DESCRIPTION
        calls malloc (see malloc(3)) to create the tree and must be freed after
        fibfree has been called.
 
+       A heap that never allocates is initialized by calling fibinitbuf with a
+       buffer arr of arrlen node pointers to use for maintenance of the heap.
+       Fibarrlen returns the number of entries needed by a heap holding at
+       most n nodes. As long as the heap does not outgrow the buffer,
+       fibdeletemin and fibdelete never fail and fibfree does not free the
+       buffer.
+
        The minimum element in the heap is stored in the min member of the Fib-
        heap struct. If min is NULL  then  the  heap  is  empty.   Fibdeletemin
        removes  the  minimum element from the heap and queues the next item in
        the min field. This may require a memory allocation and will return  -1
-       in  case  of failure.  Keys in a node can be changed as long as the new
+       in  case  of failure, in which case the minimum is still removed and the
+       rest of the heap is left whole but unconsolidated.  Keys in a node can be changed as long as the new
        value is not greater than the old value. In  that  case  Fibdecreasekey
-       must be called to re-establish heap order on the heap.  Any node can be
-       removed from the heap by calling fibdelete.  In the case where the node
-       is  the  minimum node, allocation may occur and the function returns -1
-       in case of failure.
+       must be called to re-establish heap order on the heap.  Fibupdatekey
+       re-establishes heap order after a key has changed in either direction.
+       It cuts the node from its parent if it now orders before it and cuts
+       each child that now orders before the node, the  cuts  cascading  as
+       in fibdecreasekey, and if the node was the minimum it scans the roots
+       for the new one. It only cuts and never links, so unlike deleting and
+       reinserting the node it neither allocates nor fails.
+       Any node can be removed from the heap by calling fibdelete.  In the
+       case where the node is the minimum node, allocation may occur and the
+       function returns -1 in case of failure.
+
+       Fibinsertmany inserts the n nodes of an array at once, linking them
+       into one list and splicing it into the heap after a single scan for its
+       minimum. Fibpopmany removes up to k of the smallest nodes, stores them
+       in order in out, and returns how many it removed. If a consolidation
+       needs an allocation which fails it stops there and returns the number
+       of nodes removed so far. Neither saves comparisons: finding the minimum
+       of n nodes takes the n-1 comparisons that n calls to fibinsert make,
+       and fibpopmany is k calls to fibdeletemin.  Fibinsertmany only saves
+       the splicing of each node into the root list on its own.
+
+       Normally fibdeletemin consolidates the whole root list at once, which
+       after many insertions is a long pause. Calling fibsetstep with a step
+       greater than zero caps the number of roots consolidated by each
+       fibinsert, fibdeletemin, fibdecreasekey, fibupdatekey, and fibdelete
+       and carries the rest over to later operations. The min member stays correct throughout
+       and a failed allocation only defers consolidation, so in this mode the
+       routines do not fail. Switching a heap with nodes in it to this mode,
+       or melding another heap into it, consolidates it in full once. A step
+       of zero consolidates everything on each fibdeletemin again.
 
 EXAMPLES
        Typical usage is to embed the Fibnode structure as the first member  of
@@ -201,13 +250,43 @@ extern "C" {
 
 typedef struct Fibheap Fibheap;
 typedef struct Fibnode Fibnode;
+typedef struct Fibstats Fibstats;
 typedef int (*Fibcmp)(Fibnode*, Fibnode*);
 
+enum {
+	FIBSTATNHIST = 32,
+};
+
+/*
+ * Counters kept when BSP_FIBHEAP_STATS is defined. Cascade[i] counts
+ * cascading cuts that cut i nodes and roothist[i] counts full
+ * consolidations of a root list of between 2^i and 2^(i+1)-1 roots.
+ */
+struct Fibstats {
+	unsigned long ncmp;
+	unsigned long nlink;
+	unsigned long ncut;
+	unsigned long cascade[FIBSTATNHIST];
+	unsigned long nconsolidate;
+	unsigned long rootsum;
+	unsigned long rootmax;
+	unsigned long roothist[FIBSTATNHIST];
+	unsigned long nresize;
+	int arrpeak;
+	int rankpeak;
+};
+
 struct Fibheap {
 	Fibcmp cmp;
 	Fibnode *min;
 	Fibnode **arr;
 	int arrlen;
+	int arrfixed;
+	Fibnode *pend;
+	int step;
+#ifdef BSP_FIBHEAP_STATS
+	Fibstats stats;
+#endif
 };
 
 struct Fibnode {
@@ -217,22 +296,25 @@ struct Fibnode {
 };
 
 __BSP_FIBHEAP_SCOPE Fibheap* fibinit(Fibheap *heap, Fibcmp cmp);
+__BSP_FIBHEAP_SCOPE Fibheap* fibinitbuf(Fibheap *heap, Fibcmp cmp, Fibnode **arr, int arrlen);
+__BSP_FIBHEAP_SCOPE int      fibarrlen(unsigned long);
+__BSP_FIBHEAP_SCOPE void     fibsetstep(Fibheap*, int);
+__BSP_FIBHEAP_SCOPE Fibstats *fibstats(Fibheap*);
 __BSP_FIBHEAP_SCOPE Fibheap *fibcreate(Fibcmp);
 __BSP_FIBHEAP_SCOPE Fibheap *fibfree(Fibheap*);
 __BSP_FIBHEAP_SCOPE Fibheap *fibmeld(Fibheap*, Fibheap*);
 __BSP_FIBHEAP_SCOPE void     fibinsert(Fibheap*, Fibnode*);
+__BSP_FIBHEAP_SCOPE void     fibinsertmany(Fibheap*, Fibnode**, int);
 __BSP_FIBHEAP_SCOPE int      fibdeletemin(Fibheap*);
+__BSP_FIBHEAP_SCOPE int      fibpopmany(Fibheap*, Fibnode**, int);
 __BSP_FIBHEAP_SCOPE void     fibdecreasekey(Fibheap*, Fibnode*);
+__BSP_FIBHEAP_SCOPE void     fibupdatekey(Fibheap*, Fibnode*);
 __BSP_FIBHEAP_SCOPE int      fibdelete(Fibheap*, Fibnode*);
 
 #ifdef __cpluscplus
 }
 #endif
 
-#endif // __BSP_FIBHEAP_H_INCLUDE
-
-#ifdef BSP_FIBHEAP_IMPLEMENTATION
-
 #ifndef BSP_FIBHEAP_CALLOC
 #include <stdlib.h>
 #define BSP_FIBHEAP_CALLOC calloc
@@ -243,281 +325,799 @@ __BSP_FIBHEAP_SCOPE int      fibdelete(Fibheap*, Fibnode*);
 #define BSP_FIBHEAP_FREE free
 #endif
 
+#include <limits.h>
+#include <stddef.h>
 #include <string.h>
 
-__BSP_FIBHEAP_SCOPE
-Fibheap*
-fibinit(Fibheap *heap, Fibcmp cmp)
-{
-	heap->cmp = cmp;
-	heap->min = NULL;
-	heap->arr = NULL;
-	heap->arrlen = 0;
-
-	return heap;
-}
+#ifdef BSP_FIBHEAP_STATS
+#define __BSP_FIBSTAT(x) x
 
-__BSP_FIBHEAP_SCOPE
-Fibheap*
-fibfree(Fibheap *h)
+static inline void
+fibstatroots(Fibstats *st, unsigned long len, int maxrank)
 {
-	BSP_FIBHEAP_FREE(h->arr);
-	return h;
+	int i;
+
+	st->nconsolidate++;
+	st->rootsum += len;
+	if(st->rootmax < len) st->rootmax = len;
+	for(i = 0; len > 1 && i < FIBSTATNHIST-1; i++)
+		len >>= 1;
+	st->roothist[i]++;
+	if(st->rankpeak < maxrank) st->rankpeak = maxrank;
 }
+#else
+#define __BSP_FIBSTAT(x)
+#endif
 
-static Fibnode*
-concat(Fibnode *h1, Fibnode *h2)
-{
-	Fibnode *prev;
-
-	if(h1 == NULL) return h2;
-	if(h2 == NULL) return h1;
-
-	h1->prev->next = h2;
-	h2->prev->next = h1;
+/*
+ * __BSP_FIBHEAP_BODY(pre, scope, lt) is the whole heap, emitted once
+ * for the function pointer routines and once more for each
+ * BSP_FIBHEAP_DEFINE. Its routines are named by pre, the public ones
+ * are declared with scope and lt(h, x, y) says whether node x orders
+ * before node y.
+ */
+#define __BSP_FIBHEAP_BODY(pre, scope, lt) \
+\
+static inline Fibnode* \
+pre##concat(Fibnode *h1, Fibnode *h2) \
+{ \
+	Fibnode *prev; \
+\
+	if(h1 == NULL) return h2; \
+	if(h2 == NULL) return h1; \
+\
+	h1->prev->next = h2; \
+	h2->prev->next = h1; \
+\
+	prev = h1->prev; \
+	h1->prev = h2->prev; \
+	h2->prev = prev; \
+	return h1; \
+} \
+\
+static inline Fibnode* \
+pre##meld1(Fibheap *h, Fibnode *h1, Fibnode *h2) \
+{ \
+	if(h1 == NULL) return h2; \
+	if(h2 == NULL) return h1; \
+\
+	pre##concat(h1, h2); \
+	return lt(h, h2, h1) ? h2 : h1; \
+} \
+\
+static inline Fibnode* \
+pre##initnode(Fibnode *n) \
+{ \
+	n->p = NULL; \
+	n->c = NULL; \
+	n->next = n; \
+	n->prev = n; \
+	n->rank = 0; \
+	n->mark = 0; \
+	return n; \
+} \
+\
+static inline Fibnode* \
+pre##removenode(Fibnode *n) \
+{ \
+	Fibnode *next; \
+\
+	n->p = NULL; \
+	if(n->next == n) return NULL; \
+\
+	next = n->next; \
+	n->next->prev = n->prev; \
+	n->prev->next = n->next; \
+\
+	n->next = n; \
+	n->prev = n; \
+\
+	return next; \
+} \
+\
+static inline Fibnode* \
+pre##detachchildren(Fibnode *p) \
+{ \
+	Fibnode *c; \
+\
+	c = p->c; \
+	if(c != NULL) do { \
+		c->p = NULL; \
+		c = c->next; \
+	} while(c != p->c); \
+	p->c = NULL; \
+	return c; \
+} \
+\
+static inline Fibnode* \
+pre##scanmin(Fibheap *h, Fibnode *head) \
+{ \
+	Fibnode *n, *min; \
+\
+	min = head; \
+	for(n = head->next; n != head; n = n->next) { \
+		if(lt(h, n, min)) min = n; \
+	} \
+	return min; \
+} \
+\
+/* \
+ * In incremental mode the roots are either in the pend list, waiting \
+ * to be consolidated, or alone in the arr slot for their degree. \
+ * Otherwise all roots are on the list through min. \
+ */ \
+static inline void \
+pre##addroot(Fibheap *h, Fibnode *n) \
+{ \
+	if(h->step == 0) { \
+		h->min = pre##meld1(h, h->min, n); \
+		return; \
+	} \
+	h->pend = pre##concat(h->pend, n); \
+	if(h->min == NULL || lt(h, n, h->min)) h->min = n; \
+} \
+\
+static inline Fibnode* \
+pre##link(Fibheap *h, Fibnode *x, Fibnode *y) \
+{ \
+	Fibnode *t; \
+\
+	__BSP_FIBSTAT(h->stats.nlink++;) \
+	if(lt(h, y, x)) { \
+		t = x; \
+		x = y; \
+		y = t; \
+	} \
+	x->c = pre##concat(x->c, y); \
+	y->p = x; \
+	y->mark = 0; \
+	x->rank++; \
+	return x; \
+} \
+\
+static inline int \
+pre##resizearr(Fibheap *h, int rank) \
+{ \
+	Fibnode **a; \
+	int alen; \
+\
+	if(h->arrfixed) return -1; \
+	alen = 2*rank + 10; \
+	a = BSP_FIBHEAP_CALLOC(alen, sizeof(*a)); \
+	if(a == NULL) return -1; \
+	if(h->arr != NULL) memcpy(a, h->arr, h->arrlen*sizeof(*a)); \
+	BSP_FIBHEAP_FREE(h->arr); \
+	h->arr = a; \
+	h->arrlen = alen; \
+	__BSP_FIBSTAT(h->stats.nresize++;) \
+	__BSP_FIBSTAT(h->stats.arrpeak = alen;) \
+	return 0; \
+} \
+\
+/* \
+ * Roots are binned by degree. A root of degree k heads a tree of at \
+ * least F(k+2) nodes so arr never grows past log_phi(n) slots and, \
+ * once it has grown to fit the heap, consolidation does not allocate. \
+ * Meldheaps clears the slots it visits so arr is all NULL between \
+ * calls and nothing else needs resetting. If arr cannot grow, *np is \
+ * left pointing at the tree that was being linked, which by then may \
+ * hold other roots under the one passed in. \
+ */ \
+static inline int \
+pre##arraylink(Fibheap *h, Fibnode **np) \
+{ \
+	Fibnode *m, *n; \
+\
+	n = *np; \
+	for(;;) { \
+		if(h->arrlen <= n->rank && pre##resizearr(h, n->rank) == -1) { \
+			*np = n; \
+			return -1; \
+		} \
+		m = h->arr[n->rank]; \
+		if(m == NULL) { \
+			h->arr[n->rank] = n; \
+			return n->rank; \
+		} \
+		h->arr[n->rank] = NULL; \
+		n = pre##link(h, m, n); \
+		if(h->min != NULL && h->min->p != NULL) h->min = n; \
+	} \
+} \
+\
+/* \
+ * Undo a linkheaps that could not grow arr: the trees it binned, the \
+ * tree n it was holding and the roots from next on that it had not \
+ * reached go back on the root list, which is then whole again but \
+ * unconsolidated. \
+ */ \
+static inline void \
+pre##unlinkheaps(Fibheap *h, Fibnode *n, Fibnode *next, Fibnode *head) \
+{ \
+	Fibnode **ni, *m; \
+\
+	while(next != head) { \
+		m = next; \
+		next = m->next; \
+		m->next = m; \
+		m->prev = m; \
+		n = pre##concat(n, m); \
+	} \
+	for(ni = h->arr; ni < h->arr + h->arrlen; ni++) { \
+		n = pre##concat(n, *ni); \
+		*ni = NULL; \
+	} \
+	h->min = pre##scanmin(h, n); \
+} \
+\
+static inline int \
+pre##linkheaps(Fibheap *h, Fibnode *head) \
+{ \
+	Fibnode *n, *next; \
+	int rank, maxrank; \
+	__BSP_FIBSTAT(unsigned long len = 0;) \
+\
+	maxrank = 0; \
+	n = head; \
+	do { \
+		next = n->next; \
+		n->next = n; \
+		n->prev = n; \
+		rank = pre##arraylink(h, &n); \
+		if(rank == -1) { \
+			pre##unlinkheaps(h, n, next, head); \
+			return -1; \
+		} \
+		if(maxrank < rank) maxrank = rank; \
+		__BSP_FIBSTAT(len++;) \
+		n = next; \
+	} while(n != head); \
+\
+	__BSP_FIBSTAT(fibstatroots(&h->stats, len, maxrank);) \
+	return maxrank; \
+} \
+\
+static inline void \
+pre##meldheaps(Fibheap *h, int maxrank) \
+{ \
+	Fibnode **ni; \
+\
+	h->min = NULL; \
+	for(ni = h->arr; ni <= h->arr + maxrank; ni++) { \
+		if(*ni == NULL) continue; \
+		h->min = pre##meld1(h, h->min, *ni); \
+		*ni = NULL; \
+	} \
+} \
+\
+static inline int \
+pre##linkstep(Fibheap *h, Fibnode *head) \
+{ \
+	int maxrank; \
+\
+	maxrank = pre##linkheaps(h, head); \
+	if(maxrank == -1) return -1; \
+	pre##meldheaps(h, maxrank); \
+	return 0; \
+} \
+\
+static inline int \
+pre##inarr(Fibheap *h, Fibnode *n) \
+{ \
+	return n->rank < h->arrlen && h->arr[n->rank] == n; \
+} \
+\
+/* \
+ * Link up to step roots from pend into arr. This is the work a full \
+ * consolidation would do, spread over the following operations. \
+ * Callers pass the number of roots they added plus h->step so pend \
+ * shrinks with every operation and the scan in findmin stays short. \
+ * If arr cannot grow the tree goes back on pend for a later try. \
+ */ \
+static inline void \
+pre##consolidate(Fibheap *h, int step) \
+{ \
+	Fibnode *n; \
+\
+	while(step-- > 0 && h->pend != NULL) { \
+		n = h->pend; \
+		h->pend = pre##removenode(n); \
+		if(pre##arraylink(h, &n) == -1) { \
+			h->pend = pre##concat(h->pend, n); \
+			return; \
+		} \
+	} \
+} \
+\
+static inline Fibnode* \
+pre##findmin(Fibheap *h) \
+{ \
+	Fibnode **ni, *n, *min; \
+\
+	min = NULL; \
+	for(ni = h->arr; ni < h->arr + h->arrlen; ni++) { \
+		if(*ni == NULL) continue; \
+		if(min == NULL || lt(h, *ni, min)) min = *ni; \
+	} \
+	n = h->pend; \
+	if(n != NULL) do { \
+		if(min == NULL || lt(h, n, min)) min = n; \
+		n = n->next; \
+	} while(n != h->pend); \
+	return min; \
+} \
+\
+/* Take a root off pend or out of arr. */ \
+static inline void \
+pre##unroot(Fibheap *h, Fibnode *n) \
+{ \
+	Fibnode *next; \
+\
+	if(pre##inarr(h, n)) { \
+		h->arr[n->rank] = NULL; \
+		return; \
+	} \
+	next = pre##removenode(n); \
+	if(h->pend == n) h->pend = next; \
+} \
+\
+static inline Fibnode* \
+pre##rootlist(Fibheap *h) \
+{ \
+	Fibnode **ni, *list; \
+\
+	if(h->step == 0) return h->min; \
+\
+	list = h->pend; \
+	h->pend = NULL; \
+	for(ni = h->arr; ni < h->arr + h->arrlen; ni++) { \
+		list = pre##concat(list, *ni); \
+		*ni = NULL; \
+	} \
+	return list; \
+} \
+\
+scope \
+Fibheap* \
+pre##free(Fibheap *h) \
+{ \
+	if(!h->arrfixed) BSP_FIBHEAP_FREE(h->arr); \
+	return h; \
+} \
+\
+scope \
+Fibheap* \
+pre##meld(Fibheap *h1, Fibheap *h2) \
+{ \
+	Fibnode *list, *min; \
+\
+	min = h2->min; \
+	list = pre##rootlist(h2); \
+	h2->min = NULL; \
+	if(h1->step == 0) \
+		pre##concat(h1->min, list); \
+	else \
+		h1->pend = pre##concat(h1->pend, list); \
+	if(h1->min == NULL || (min != NULL && lt(h1, min, h1->min))) \
+		h1->min = min; \
+	/* Consolidate the new roots now rather than scan them in every findmin. */ \
+	if(h1->step > 0) \
+		pre##consolidate(h1, INT_MAX); \
+	return h1; \
+} \
+\
+/* \
+ * A step greater than zero caps the number of roots consolidated by \
+ * each operation and leaves the rest for later ones. Zero goes back \
+ * to consolidating the whole root list on each deletemin. Switching \
+ * a heap to steps consolidates it in full, since each operation only \
+ * consolidates about as many roots as it adds and findmin would \
+ * otherwise scan the old root list on every deletemin. \
+ */ \
+scope \
+void \
+pre##setstep(Fibheap *h, int step) \
+{ \
+	if(step < 0) step = 0; \
+	if(step > 0 && h->step == 0) { \
+		h->pend = h->min; \
+		h->step = step; \
+		pre##consolidate(h, INT_MAX); \
+		return; \
+	} \
+	if(step == 0 && h->step > 0) \
+		pre##rootlist(h); \
+	h->step = step; \
+} \
+\
+scope \
+void \
+pre##insert(Fibheap *h, Fibnode *n) \
+{ \
+	pre##addroot(h, pre##initnode(n)); \
+	if(h->step > 0) pre##consolidate(h, h->step); \
+} \
+\
+/* \
+ * Link the nodes into one list while finding its minimum and splice \
+ * it into the heap with a single comparison against the old min. That \
+ * is as many comparisons as inserting them one by one. \
+ */ \
+scope \
+void \
+pre##insertmany(Fibheap *h, Fibnode **a, int len) \
+{ \
+	Fibnode *head, *min, **ni; \
+\
+	if(len <= 0) return; \
+\
+	head = min = pre##initnode(a[0]); \
+	for(ni = a+1; ni < a+len; ni++) { \
+		pre##initnode(*ni); \
+		(*ni)->prev = head->prev; \
+		(*ni)->next = head; \
+		head->prev->next = *ni; \
+		head->prev = *ni; \
+		if(lt(h, *ni, min)) min = *ni; \
+	} \
+\
+	if(h->step > 0) { \
+		h->pend = pre##concat(h->pend, head); \
+		if(h->min == NULL || lt(h, min, h->min)) h->min = min; \
+		pre##consolidate(h, h->step + len); \
+		return; \
+	} \
+	pre##concat(h->min, head); \
+	if(h->min == NULL || lt(h, min, h->min)) h->min = min; \
+} \
+\
+scope \
+int \
+pre##deletemin(Fibheap *h) \
+{ \
+	Fibnode *head, *min; \
+	int added; \
+\
+	min = h->min; \
+	if(min == NULL) return 0; \
+\
+	if(h->step > 0) { \
+		pre##unroot(h, min); \
+		added = min->rank; \
+		h->pend = pre##concat(h->pend, pre##detachchildren(min)); \
+		h->min = NULL; \
+		pre##consolidate(h, h->step + added); \
+		h->min = pre##findmin(h); \
+		return 0; \
+	} \
+\
+	head = pre##concat(pre##removenode(min), pre##detachchildren(min)); \
+	if(head == NULL) { \
+		h->min = NULL; \
+		return 0; \
+	} \
+\
+	return pre##linkstep(h, head); \
+} \
+\
+/* \
+ * Pop up to k nodes into out in order. A top-k walk of the consolidated \
+ * forest would compare about as often as the consolidations it replaces, \
+ * so each pop is a plain deletemin. Returns the number of nodes popped, \
+ * which is fewer than k if a consolidation failed to allocate. \
+ */ \
+scope \
+int \
+pre##popmany(Fibheap *h, Fibnode **out, int k) \
+{ \
+	int i; \
+\
+	for(i = 0; i < k && h->min != NULL; i++) { \
+		out[i] = h->min; \
+		if(pre##deletemin(h) == -1) return i+1; \
+	} \
+	return i; \
+} \
+\
+/* Returns the number of roots added. */ \
+static inline int \
+pre##cut(Fibheap *h, Fibnode *n) \
+{ \
+	Fibnode *p; \
+	int moved; \
+\
+	__BSP_FIBSTAT(h->stats.ncut++;) \
+	p = n->p; \
+	moved = h->step > 0 && p->p == NULL && pre##inarr(h, p); \
+	if(moved) h->arr[p->rank] = NULL; \
+	p->rank--; \
+	p->c = pre##removenode(n); \
+	pre##addroot(h, n); \
+	if(moved) h->pend = pre##concat(h->pend, p); \
+	return 1 + moved; \
+} \
+\
+static inline int \
+pre##cascadingcut(Fibheap *h, Fibnode *n) \
+{ \
+	Fibnode *p; \
+	int added; \
+	__BSP_FIBSTAT(int depth = 0;) \
+\
+	added = 0; \
+	for(;;) { \
+		p = n->p; \
+		added += pre##cut(h, n); \
+		__BSP_FIBSTAT(depth++;) \
+		if(p->p == NULL) break; \
+		if(!p->mark) { \
+			p->mark = 1; \
+			break; \
+		} \
+		n = p; \
+	} \
+	__BSP_FIBSTAT(h->stats.cascade[depth < FIBSTATNHIST ? depth : FIBSTATNHIST-1]++;) \
+	return added; \
+} \
+\
+scope \
+void \
+pre##decreasekey(Fibheap *h, Fibnode *n) \
+{ \
+	int added; \
+\
+	if(n->p == NULL) { \
+		if(lt(h, n, h->min)) h->min = n; \
+		return; \
+	} \
+\
+	if(lt(h, n->p, n)) return; \
+\
+	added = pre##cascadingcut(h, n); \
+	if(h->step > 0) pre##consolidate(h, h->step + added); \
+} \
+\
+/* \
+ * Only cuts, never links, so it does not allocate. A minimum whose key \
+ * went up stays a root and the new minimum is found by scanning the \
+ * roots, which its cut children have joined. \
+ */ \
+scope \
+void \
+pre##updatekey(Fibheap *h, Fibnode *n) \
+{ \
+	Fibnode *c, *next; \
+	int wasmin, added, i, k; \
+\
+	wasmin = h->min == n; \
+	added = 0; \
+	if(n->p != NULL && lt(h, n, n->p)) \
+		added += pre##cascadingcut(h, n); \
+	else if(n->p == NULL && !wasmin && lt(h, n, h->min)) \
+		h->min = n; \
+\
+	/* Cut the children that now order before n, as if each were decreased. */ \
+	c = n->c; \
+	k = n->rank; \
+	for(i = 0; i < k; i++, c = next) { \
+		next = c->next; \
+		if(lt(h, c, n)) added += pre##cascadingcut(h, c); \
+	} \
+\
+	if(h->step > 0) pre##consolidate(h, h->step + added); \
+	if(wasmin) h->min = h->step > 0 ? pre##findmin(h) : pre##scanmin(h, n); \
+} \
+\
+scope \
+int \
+pre##delete(Fibheap *h, Fibnode *n) \
+{ \
+	int added; \
+\
+	if(h->min == n) return pre##deletemin(h); \
+\
+	added = 0; \
+	if(n->p != NULL) added = pre##cascadingcut(h, n); \
+\
+	if(h->step > 0) { \
+		pre##unroot(h, n); \
+		added += n->rank; \
+		h->pend = pre##concat(h->pend, pre##detachchildren(n)); \
+		pre##consolidate(h, h->step + added); \
+		return 0; \
+	} \
+\
+	pre##removenode(n); \
+	pre##concat(h->min, pre##detachchildren(n)); \
+	return 0; \
+}
 
-	prev = h1->prev;
-	h1->prev = h2->prev;
-	h2->prev = prev;
-	return h1;
+/*
+ * BSP_FIBHEAP_DEFINE(prefix, type, member, less) emits a Fibonacci heap
+ * specialized to nodes of type with their Fibnode in member. Less is a
+ * function or function-like macro taking two type pointers and
+ * returning whether the first orders before the second; it is called
+ * directly so the comparisons can be inlined. The heap is the same
+ * __BSP_FIBHEAP_BODY as the function pointer routines, under names
+ * starting with prefix_, wrapped in static inline routines that take
+ * and return type pointers and otherwise behave as fibinit,
+ * fibinitbuf, fibfree, fibmeld, fibinsert, fibdeletemin,
+ * fibdecreasekey, fibupdatekey, and fibdelete, always consolidating in
+ * full. They share the Fibheap and Fibnode structures but leave the
+ * cmp member unset, so a heap must only be used through one set of
+ * routines. For example
+ *
+ *	#define NODELESS(a, b) ((a)->dist < (b)->dist)
+ *	BSP_FIBHEAP_DEFINE(nodeheap, Node, fibnode, NODELESS)
+ *
+ * defines nodeheapinit, nodeheapinsert, nodeheapmin and so on.
+ */
+#define __BSP_FIBHEAP_NODE(type, member, n) \
+	((type*)((char*)(n) - offsetof(type, member)))
+
+#define BSP_FIBHEAP_DEFINE(prefix, type, member, less) \
+\
+static inline int \
+prefix##_lt(Fibheap *h, Fibnode *x, Fibnode *y) \
+{ \
+	(void)h; \
+	__BSP_FIBSTAT(h->stats.ncmp++;) \
+	return less(__BSP_FIBHEAP_NODE(type, member, x), __BSP_FIBHEAP_NODE(type, member, y)); \
+} \
+\
+__BSP_FIBHEAP_BODY(prefix##_, static inline, prefix##_lt) \
+\
+static inline Fibheap* \
+prefix##init(Fibheap *h) \
+{ \
+	memset(h, 0, sizeof(*h)); \
+	return h; \
+} \
+\
+static inline Fibheap* \
+prefix##initbuf(Fibheap *h, Fibnode **arr, int arrlen) \
+{ \
+	prefix##init(h); \
+	h->arr = arr; \
+	h->arrlen = arrlen; \
+	h->arrfixed = 1; \
+	memset(arr, 0, sizeof(*arr) * arrlen); \
+	return h; \
+} \
+\
+static inline Fibheap* \
+prefix##free(Fibheap *h) \
+{ \
+	return prefix##_free(h); \
+} \
+\
+static inline type* \
+prefix##min(Fibheap *h) \
+{ \
+	return h->min == NULL ? NULL : __BSP_FIBHEAP_NODE(type, member, h->min); \
+} \
+\
+static inline Fibheap* \
+prefix##meld(Fibheap *h1, Fibheap *h2) \
+{ \
+	return prefix##_meld(h1, h2); \
+} \
+\
+static inline void \
+prefix##insert(Fibheap *h, type *t) \
+{ \
+	prefix##_insert(h, &t->member); \
+} \
+\
+static inline int \
+prefix##deletemin(Fibheap *h) \
+{ \
+	return prefix##_deletemin(h); \
+} \
+\
+static inline void \
+prefix##decreasekey(Fibheap *h, type *t) \
+{ \
+	prefix##_decreasekey(h, &t->member); \
+} \
+\
+static inline void \
+prefix##updatekey(Fibheap *h, type *t) \
+{ \
+	prefix##_updatekey(h, &t->member); \
+} \
+\
+static inline int \
+prefix##delete(Fibheap *h, type *t) \
+{ \
+	return prefix##_delete(h, &t->member); \
 }
 
-static Fibnode*
-meld(Fibnode *h1, Fibnode *h2, Fibcmp cmp)
-{
-	if(h1 == NULL) return h2;
-	if(h2 == NULL) return h1;
+#endif // __BSP_FIBHEAP_H_INCLUDE
 
-	concat(h1, h2);
-	return cmp(h1, h2) <= 0 ? h1 : h2;
-}
+#ifdef BSP_FIBHEAP_IMPLEMENTATION
 
 __BSP_FIBHEAP_SCOPE
 Fibheap*
-fibmeld(Fibheap *h1, Fibheap *h2)
+fibinit(Fibheap *heap, Fibcmp cmp)
 {
-	h1->min = meld(h1->min, h2->min, h1->cmp);
-	return h1;
-}
+	heap->cmp = cmp;
+	heap->min = NULL;
+	heap->arr = NULL;
+	heap->arrlen = 0;
+	heap->arrfixed = 0;
+	heap->pend = NULL;
+	heap->step = 0;
+	__BSP_FIBSTAT(memset(&heap->stats, 0, sizeof(heap->stats));)
 
-static Fibnode*
-initnode(Fibnode *n)
-{
-	n->p = NULL;
-	n->c = NULL;
-	n->next = n;
-	n->prev = n;
-	n->rank = 0;
-	n->mark = 0;
-	return n;
+	return heap;
 }
 
 __BSP_FIBHEAP_SCOPE
-void
-fibinsert(Fibheap *h, Fibnode *n)
-{
-	h->min = meld(h->min, initnode(n), h->cmp);
-}
-
-static Fibnode*
-link1(Fibnode *x, Fibnode *y)
-{
-	x->c = concat(x->c, y);
-	y->p = x;
-	y->mark = 0;
-	x->rank += y->rank + 1;
-	return x;
-}
-
-static Fibnode*
-link(Fibnode *x, Fibnode *y, Fibcmp cmp)
-{
-	if(cmp(x, y) <= 0) return link1(x, y);
-	else               return link1(y, x);
-}
-
-static int
-resizearr(Fibheap *h, int rank)
-{
-	Fibnode **a;
-	int alen;
-
-	alen = 2*rank + 10;
-	a = BSP_FIBHEAP_CALLOC(alen, sizeof(*a));
-	if(a == NULL) return -1;
-	memcpy(a, h->arr, h->arrlen*sizeof(*a));
-	free(h->arr);
-	h->arr = a;
-	h->arrlen = alen;
-	return 0;
-}
-
-static int
-arraylink(Fibheap *h, Fibnode *n)
-{
-	Fibnode *m;
-
-	for(;;) {
-		if(h->arrlen <= n->rank && resizearr(h, n->rank) == -1) return -1;
-		m = h->arr[n->rank];
-		if(m == NULL) {
-			h->arr[n->rank] = n;
-			return n->rank;
-		}
-		h->arr[n->rank] = NULL;
-		n = link(m, n, h->cmp);
-	}
-}
-
-static int
-linkheaps(Fibheap *h, Fibnode *head)
-{
-	Fibnode *n, *next;
-	int rank, maxrank;
-
-	memset(h->arr, 0, sizeof(*h->arr) * h->arrlen);
-
-	maxrank = 0;
-	n = head;
-	do {
-		next = n->next;
-		n->next = n;
-		n->prev = n;
-		rank = arraylink(h, n);
-		if(rank == -1) return -1;
-		if(maxrank < rank) maxrank = rank;
-		n = next;
-	} while(n != head);
-
-	return maxrank;
-}
-
-static void
-meldheaps(Fibheap *h, int maxrank)
-{
-	Fibnode **ni;
-
-	h->min = NULL;
-	for(ni = h->arr; ni <= h->arr + maxrank; ni++) {
-		if(*ni != NULL) h->min = meld(h->min, *ni, h->cmp);
-	}
-}
-
-static int
-linkstep(Fibheap *h, Fibnode *head)
-{
-	int maxrank;
-
-	maxrank = linkheaps(h, head);
-	if(maxrank == -1) return -1;
-	meldheaps(h, maxrank);
-	return 0;
-}
-
-static Fibnode*
-removenode(Fibnode *n)
+Fibheap*
+fibinitbuf(Fibheap *heap, Fibcmp cmp, Fibnode **arr, int arrlen)
 {
-	Fibnode *next;
-
-	n->p = NULL;
-	if(n->next == n) return NULL;
-
-	next = n->next;
-	n->next->prev = n->prev;
-	n->prev->next = n->next;
-
-	n->next = n;
-	n->prev = n;
-
-	return next;
-}
+	heap->cmp = cmp;
+	heap->min = NULL;
+	heap->arr = arr;
+	heap->arrlen = arrlen;
+	heap->arrfixed = 1;
+	heap->pend = NULL;
+	heap->step = 0;
+	memset(arr, 0, sizeof(*arr) * arrlen);
+	__BSP_FIBSTAT(memset(&heap->stats, 0, sizeof(heap->stats));)
+	__BSP_FIBSTAT(heap->stats.arrpeak = arrlen;)
 
-static Fibnode*
-detachchildren(Fibnode *p)
-{
-	Fibnode *c;
-
-	c = p->c;
-	if(c != NULL) do {
-		c->p = NULL;
-		c = c->next;
-	} while(c != p->c);
-	p->c = NULL;
-	return c;
+	return heap;
 }
 
+/*
+ * A root of degree k has at least F(k+2) descendants, so a heap
+ * of n nodes only ever uses the slots for degrees with F(k+2) <= n.
+ */
 __BSP_FIBHEAP_SCOPE
 int
-fibdeletemin(Fibheap *h)
-{
-	Fibnode *head, *min;
-
-	min = h->min;
-	if(min == NULL) return 0;
-
-	head = concat(removenode(min), detachchildren(min));
-	if(head == NULL) {
-		h->min = NULL;
-		return 0;
-	}
-
-	return linkstep(h, head);
-}
-
-static void
-cut(Fibheap *h, Fibnode *n)
+fibarrlen(unsigned long n)
 {
-	Fibnode *p;
-
-	p = n->p;
-	p->rank -= n->rank + 1;
-	p->c = removenode(n);
-	h->min = meld(h->min, n, h->cmp);
-}
-
-static void
-cascadingcut(Fibheap *h, Fibnode *n)
-{
-	Fibnode *p;
-
-Loop:
-	p = n->p;
-	cut(h, n);
-	if(p->p == NULL) return;
-
-	if(p->mark) {
-		n = p;
-		goto Loop;
+	unsigned long f, g, t;
+	int len;
+
+	len = 0;
+	f = 1;
+	g = 2;
+	while(f <= n) {
+		len++;
+		if(g > ULONG_MAX - f) {
+			if(g <= n) len++;
+			break;
+		}
+		t = f + g;
+		f = g;
+		g = t;
 	}
-
-	p->mark = 1;
+	return len > 0 ? len : 1;
 }
 
+// Returns NULL unless compiled with BSP_FIBHEAP_STATS.
 __BSP_FIBHEAP_SCOPE
-void
-fibdecreasekey(Fibheap *h, Fibnode *n)
+Fibstats*
+fibstats(Fibheap *h)
 {
-	if(n->p == NULL) {
-		h->min = h->cmp(h->min, n) <= 0 ? h->min : n;
-		return;
-	}
-
-	if(h->cmp(n->p, n) < 0) return;
-
-	cascadingcut(h, n);
+#ifdef BSP_FIBHEAP_STATS
+	return &h->stats;
+#else
+	(void)h;
+	return NULL;
+#endif
 }
 
-__BSP_FIBHEAP_SCOPE
-int
-fibdelete(Fibheap *h, Fibnode *n)
+static inline int
+fiblt(Fibheap *h, Fibnode *x, Fibnode *y)
 {
-	if(h->min == n) return fibdeletemin(h);
-
-	if(n->p != NULL) cascadingcut(h, n);
-
-	removenode(n);
-	concat(h->min, detachchildren(n));
-	return 0;
+	__BSP_FIBSTAT(h->stats.ncmp++;)
+	return h->cmp(x, y) < 0;
 }
 
+__BSP_FIBHEAP_BODY(fib, __BSP_FIBHEAP_SCOPE, fiblt)
+
 #endif // BSP_FIBHEAP_IMPLEMENTATION
@@ -0,0 +1,351 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a no memory allocation fibonacci heap for nodes kept in one
+array, with no dependencies.
+
+Do this:
+	#define BSP_FIBHEAP32_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_FIBHEAP32_IMPLEMENTATION
+#include "bspfibheap32.h"
+
+You can #define BSP_FIBHEAP32_STATIC before the #include to keep everything
+private to one compilation unit.
+
+This is the heap of bspfibheap.h with the links stored as 32 bit indices
+instead of pointers and the rank and mark packed into one word, which
+brings a node down from 48 to 20 bytes. The nodes must all live in one
+array of structures. Fib32init is passed the address of the Fib32node
+member of the first element and the size of an element, and node i is
+then found at base + i*stride.
+
+	Fib32heap *fib32init(Fib32heap *heap, Fib32cmp cmp, void *base, size_t stride);
+	Fib32heap *fib32meld(Fib32heap *h1, Fib32heap *h2);
+	void       fib32insert(Fib32heap *heap, uint32_t i);
+	void       fib32deletemin(Fib32heap *heap);
+	void       fib32decreasekey(Fib32heap *heap, uint32_t i);
+	void       fib32delete(Fib32heap *heap, uint32_t i);
+	Fib32node *fib32node(Fib32heap *heap, uint32_t i);
+	Fib32node *fib32min(Fib32heap *heap);
+
+The comparison function receives pointers to two Fib32nodes as with a
+Fibheap. The index of the minimum node is kept in the min member of the
+heap, FIB32NIL when the heap is empty, and fib32min returns a pointer to
+it or NULL. A heap holds fewer than 2^32 nodes so the consolidation
+array is a fixed part of the heap and none of the routines can fail.
+Fib32meld requires both heaps to share the same array.
+*/
+
+#ifdef BSP_FIBHEAP32_STATIC
+#define __BSP_FIBHEAP32_SCOPE static
+#else
+#define __BSP_FIBHEAP32_SCOPE
+#endif
+
+#ifndef __BSP_FIBHEAP32_H_INCLUDE
+#define __BSP_FIBHEAP32_H_INCLUDE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Fib32heap Fib32heap;
+typedef struct Fib32node Fib32node;
+typedef int (*Fib32cmp)(Fib32node*, Fib32node*);
+
+#define FIB32NIL 0xffffffffu
+
+enum {
+	FIB32NRANK = 48,
+};
+
+struct Fib32heap {
+	Fib32cmp cmp;
+	char *base;
+	size_t stride;
+	uint32_t min;
+	uint32_t arr[FIB32NRANK];
+};
+
+// Rankmark is the number of children shifted left once, or'd with the mark.
+struct Fib32node {
+	uint32_t p, c, next, prev;
+	uint32_t rankmark;
+};
+
+__BSP_FIBHEAP32_SCOPE Fib32heap *fib32init(Fib32heap*, Fib32cmp, void*, size_t);
+__BSP_FIBHEAP32_SCOPE Fib32heap *fib32meld(Fib32heap*, Fib32heap*);
+__BSP_FIBHEAP32_SCOPE void       fib32insert(Fib32heap*, uint32_t);
+__BSP_FIBHEAP32_SCOPE void       fib32deletemin(Fib32heap*);
+__BSP_FIBHEAP32_SCOPE void       fib32decreasekey(Fib32heap*, uint32_t);
+__BSP_FIBHEAP32_SCOPE void       fib32delete(Fib32heap*, uint32_t);
+
+static inline Fib32node*
+fib32node(Fib32heap *h, uint32_t i)
+{
+	return (Fib32node*)(h->base + i*h->stride);
+}
+
+static inline Fib32node*
+fib32min(Fib32heap *h)
+{
+	return h->min == FIB32NIL ? NULL : fib32node(h, h->min);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_FIBHEAP32_H_INCLUDE
+
+#ifdef BSP_FIBHEAP32_IMPLEMENTATION
+
+#define N(i) fib32node(h, i)
+#define RANK(n) ((n)->rankmark >> 1)
+#define MARK(n) ((n)->rankmark & 1)
+
+__BSP_FIBHEAP32_SCOPE
+Fib32heap*
+fib32init(Fib32heap *h, Fib32cmp cmp, void *base, size_t stride)
+{
+	int i;
+
+	h->cmp = cmp;
+	h->base = base;
+	h->stride = stride;
+	h->min = FIB32NIL;
+	for(i = 0; i < FIB32NRANK; i++)
+		h->arr[i] = FIB32NIL;
+	return h;
+}
+
+static uint32_t
+concat(Fib32heap *h, uint32_t i1, uint32_t i2)
+{
+	Fib32node *h1, *h2;
+	uint32_t prev;
+
+	if(i1 == FIB32NIL) return i2;
+	if(i2 == FIB32NIL) return i1;
+
+	h1 = N(i1);
+	h2 = N(i2);
+	N(h1->prev)->next = i2;
+	N(h2->prev)->next = i1;
+
+	prev = h1->prev;
+	h1->prev = h2->prev;
+	h2->prev = prev;
+	return i1;
+}
+
+static uint32_t
+meld(Fib32heap *h, uint32_t i1, uint32_t i2)
+{
+	if(i1 == FIB32NIL) return i2;
+	if(i2 == FIB32NIL) return i1;
+
+	concat(h, i1, i2);
+	return h->cmp(N(i1), N(i2)) <= 0 ? i1 : i2;
+}
+
+__BSP_FIBHEAP32_SCOPE
+Fib32heap*
+fib32meld(Fib32heap *h1, Fib32heap *h2)
+{
+	h1->min = meld(h1, h1->min, h2->min);
+	h2->min = FIB32NIL;
+	return h1;
+}
+
+__BSP_FIBHEAP32_SCOPE
+void
+fib32insert(Fib32heap *h, uint32_t i)
+{
+	Fib32node *n;
+
+	n = N(i);
+	n->p = FIB32NIL;
+	n->c = FIB32NIL;
+	n->next = i;
+	n->prev = i;
+	n->rankmark = 0;
+	h->min = meld(h, h->min, i);
+}
+
+static uint32_t
+linkpair(Fib32heap *h, uint32_t x, uint32_t y)
+{
+	Fib32node *xn, *yn;
+	uint32_t t;
+
+	if(h->cmp(N(x), N(y)) > 0) {
+		t = x;
+		x = y;
+		y = t;
+	}
+	xn = N(x);
+	yn = N(y);
+	xn->c = concat(h, xn->c, y);
+	yn->p = x;
+	yn->rankmark &= ~1u;
+	xn->rankmark += 2;
+	return x;
+}
+
+static void
+linkstep(Fib32heap *h, uint32_t head)
+{
+	Fib32node *n;
+	uint32_t i, next, m, r, maxrank;
+
+	maxrank = 0;
+	i = head;
+	do {
+		n = N(i);
+		next = n->next;
+		n->next = i;
+		n->prev = i;
+		for(;;) {
+			r = RANK(N(i));
+			m = h->arr[r];
+			if(m == FIB32NIL) {
+				h->arr[r] = i;
+				break;
+			}
+			h->arr[r] = FIB32NIL;
+			i = linkpair(h, m, i);
+		}
+		if(maxrank < r) maxrank = r;
+		i = next;
+	} while(i != head);
+
+	h->min = FIB32NIL;
+	for(r = 0; r <= maxrank; r++) {
+		if(h->arr[r] == FIB32NIL) continue;
+		h->min = meld(h, h->min, h->arr[r]);
+		h->arr[r] = FIB32NIL;
+	}
+}
+
+static uint32_t
+removenode(Fib32heap *h, uint32_t i)
+{
+	Fib32node *n;
+	uint32_t next;
+
+	n = N(i);
+	n->p = FIB32NIL;
+	if(n->next == i) return FIB32NIL;
+
+	next = n->next;
+	N(n->next)->prev = n->prev;
+	N(n->prev)->next = n->next;
+
+	n->next = i;
+	n->prev = i;
+
+	return next;
+}
+
+static uint32_t
+detachchildren(Fib32heap *h, uint32_t i)
+{
+	Fib32node *p;
+	uint32_t c;
+
+	p = N(i);
+	c = p->c;
+	if(c != FIB32NIL) do {
+		N(c)->p = FIB32NIL;
+		c = N(c)->next;
+	} while(c != p->c);
+	p->c = FIB32NIL;
+	return c;
+}
+
+__BSP_FIBHEAP32_SCOPE
+void
+fib32deletemin(Fib32heap *h)
+{
+	uint32_t head, min;
+
+	min = h->min;
+	if(min == FIB32NIL) return;
+
+	head = concat(h, removenode(h, min), detachchildren(h, min));
+	if(head == FIB32NIL) {
+		h->min = FIB32NIL;
+		return;
+	}
+
+	linkstep(h, head);
+}
+
+static void
+cascadingcut(Fib32heap *h, uint32_t i)
+{
+	Fib32node *p;
+	uint32_t pi;
+
+	for(;;) {
+		pi = N(i)->p;
+		p = N(pi);
+		p->rankmark -= 2;
+		p->c = removenode(h, i);
+		h->min = meld(h, h->min, i);
+		if(p->p == FIB32NIL) return;
+		if(!MARK(p)) break;
+		i = pi;
+	}
+	p->rankmark |= 1;
+}
+
+__BSP_FIBHEAP32_SCOPE
+void
+fib32decreasekey(Fib32heap *h, uint32_t i)
+{
+	Fib32node *n;
+
+	n = N(i);
+	if(n->p == FIB32NIL) {
+		if(h->cmp(N(h->min), n) > 0) h->min = i;
+		return;
+	}
+
+	if(h->cmp(N(n->p), n) < 0) return;
+
+	cascadingcut(h, i);
+}
+
+__BSP_FIBHEAP32_SCOPE
+void
+fib32delete(Fib32heap *h, uint32_t i)
+{
+	if(h->min == i) {
+		fib32deletemin(h);
+		return;
+	}
+
+	if(N(i)->p != FIB32NIL) cascadingcut(h, i);
+
+	removenode(h, i);
+	concat(h, h->min, detachchildren(h, i));
+}
+
+#undef N
+#undef RANK
+#undef MARK
+
+#endif // BSP_FIBHEAP32_IMPLEMENTATION
@@ -0,0 +1,163 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a compressed sparse row graph builder with dependencies on
+ANSI C compatible calloc and free routines.
+
+Do this:
+	#define BSP_GRAPH_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_GRAPH_IMPLEMENTATION
+#include "bspgraph.h"
+
+You can #define BSP_GRAPH_STATIC before the #include to keep everything
+private to one compilation unit. And #define BSP_GRAPH_CALLOC, and
+BSP_GRAPH_FREE to avoid using using calloc, and free.
+
+	Graph *graphbuild(Graph *g, int nnodes, Graphedge *edges, int nedges, int flags);
+	Graph *graphfree(Graph *g);
+
+Graphbuild turns an array of edges, each a source s, destination d and
+weight w with nodes numbered from 0, into arrays of arcs grouped by
+source node. The arcs leaving node v are g->arcs[g->off[v]] up to but
+not including g->arcs[g->off[v+1]], in the order of their edges, so a
+scan of a node's neighbours reads consecutive memory:
+
+	for(a = g->arcs + g->off[v]; a < g->arcs + g->off[v+1]; a++)
+		visit(a->d, a->w);
+
+With the GRAPHUNDIRECTED flag every edge gives an arc in each
+direction. The graph is built in two passes, counting the arcs of each
+node and then filling them in at the offsets found by summing the
+counts, and off and arcs share a single allocation which graphfree
+releases. Graphbuild returns NULL if that allocation fails or an edge
+names a node outside 0 to nnodes-1.
+*/
+
+#ifdef BSP_GRAPH_STATIC
+#define __BSP_GRAPH_SCOPE static
+#else
+#define __BSP_GRAPH_SCOPE
+#endif
+
+#ifndef __BSP_GRAPH_H_INCLUDE
+#define __BSP_GRAPH_H_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Graph Graph;
+typedef struct Graphedge Graphedge;
+typedef struct Grapharc Grapharc;
+
+enum {
+	GRAPHUNDIRECTED = 1<<0,
+};
+
+struct Graphedge {
+	int s, d, w;
+};
+
+struct Grapharc {
+	int d, w;
+};
+
+struct Graph {
+	int nnodes;
+	int narcs;
+	int *off;
+	Grapharc *arcs;
+};
+
+__BSP_GRAPH_SCOPE Graph *graphbuild(Graph*, int, Graphedge*, int, int);
+__BSP_GRAPH_SCOPE Graph *graphfree(Graph*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_GRAPH_H_INCLUDE
+
+#ifdef BSP_GRAPH_IMPLEMENTATION
+
+#ifndef BSP_GRAPH_CALLOC
+#include <stdlib.h>
+#define BSP_GRAPH_CALLOC calloc
+#endif
+
+#ifndef BSP_GRAPH_FREE
+#include <stdlib.h>
+#define BSP_GRAPH_FREE free
+#endif
+
+#include <stddef.h>
+
+__BSP_GRAPH_SCOPE
+Graph*
+graphbuild(Graph *g, int nnodes, Graphedge *edges, int nedges, int flags)
+{
+	Graphedge *e;
+	Grapharc *a;
+	size_t offsiz;
+	int undirected, i;
+
+	undirected = (flags & GRAPHUNDIRECTED) != 0;
+	for(e = edges; e < edges + nedges; e++) {
+		if(e->s < 0 || e->s >= nnodes || e->d < 0 || e->d >= nnodes)
+			return NULL;
+	}
+
+	// Round off up so the arcs that follow it are aligned.
+	offsiz = (nnodes+1) * sizeof(int);
+	offsiz = (offsiz + sizeof(Grapharc) - 1) / sizeof(Grapharc) * sizeof(Grapharc);
+	g->nnodes = nnodes;
+	g->narcs = undirected ? 2*nedges : nedges;
+	g->off = BSP_GRAPH_CALLOC(1, offsiz + g->narcs*sizeof(Grapharc));
+	if(g->off == NULL) return NULL;
+	g->arcs = (Grapharc*)((char*)g->off + offsiz);
+
+	for(e = edges; e < edges + nedges; e++) {
+		g->off[e->s+1]++;
+		if(undirected) g->off[e->d+1]++;
+	}
+	for(i = 0; i < nnodes; i++)
+		g->off[i+1] += g->off[i];
+
+	// Fill using off[v] as the cursor of v, which leaves it at off[v+1].
+	for(e = edges; e < edges + nedges; e++) {
+		a = g->arcs + g->off[e->s]++;
+		a->d = e->d;
+		a->w = e->w;
+		if(undirected) {
+			a = g->arcs + g->off[e->d]++;
+			a->d = e->s;
+			a->w = e->w;
+		}
+	}
+	for(i = nnodes; i > 0; i--)
+		g->off[i] = g->off[i-1];
+	g->off[0] = 0;
+	return g;
+}
+
+__BSP_GRAPH_SCOPE
+Graph*
+graphfree(Graph *g)
+{
+	BSP_GRAPH_FREE(g->off);
+	g->off = NULL;
+	g->arcs = NULL;
+	g->nnodes = 0;
+	g->narcs = 0;
+	return g;
+}
+
+#endif // BSP_GRAPH_IMPLEMENTATION
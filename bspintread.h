@@ -0,0 +1,259 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a reader for files of decimal integers with dependencies on
+POSIX mmap, fstat and read and on ANSI C compatible realloc and free
+routines.
+
+Do this:
+	#define BSP_INTREAD_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_INTREAD_IMPLEMENTATION
+#include "bspintread.h"
+
+The implementation needs the POSIX declarations, so #define
+_POSIX_C_SOURCE 200809L before including anything in that file when
+compiling with -std=c11. You can #define BSP_INTREAD_STATIC before the
+#include to keep everything private to one compilation unit. And #define
+BSP_INTREAD_REALLOC, and BSP_INTREAD_FREE to avoid using using realloc,
+and free.
+
+	Intreader *intreaderinit(Intreader *r, int fd);
+	Intreader *intreaderbuf(Intreader *r, char *buf, size_t len);
+	Intreader *intreaderfree(Intreader *r);
+	int        intread(Intreader *r, int *v);
+
+Intreaderinit maps fd into memory if it is a regular file and otherwise
+reads it to the end into one buffer, returning NULL if either fails.
+Intreaderbuf reads from len bytes at buf instead. Intread stores the
+next integer in *v and returns 1, or returns 0 at the end of the input.
+Any bytes other than digits and a minus sign directly before a digit
+separate integers, and integers must fit in an int.
+
+Where eight bytes are left in the input the digits are found and
+converted eight at a time in one 64 bit word. XORing '0' from each byte
+leaves the digits as bytes 0 to 9, adding 0x76 to each sets the top bit
+of the bytes that are not, and the lowest set bit gives the count of
+digits. The digits are then shifted to the top of the word and combined
+pairwise in three multiplications.
+*/
+
+#ifdef BSP_INTREAD_STATIC
+#define __BSP_INTREAD_SCOPE static
+#else
+#define __BSP_INTREAD_SCOPE
+#endif
+
+#ifndef __BSP_INTREAD_H_INCLUDE
+#define __BSP_INTREAD_H_INCLUDE
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Intreader Intreader;
+
+struct Intreader {
+	char *buf;
+	char *p, *e;
+	size_t len;
+	int mapped;
+	int owned;
+};
+
+__BSP_INTREAD_SCOPE Intreader *intreaderinit(Intreader*, int);
+__BSP_INTREAD_SCOPE Intreader *intreaderbuf(Intreader*, char*, size_t);
+__BSP_INTREAD_SCOPE Intreader *intreaderfree(Intreader*);
+__BSP_INTREAD_SCOPE int        intread(Intreader*, int*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_INTREAD_H_INCLUDE
+
+#ifdef BSP_INTREAD_IMPLEMENTATION
+
+#ifndef BSP_INTREAD_REALLOC
+#include <stdlib.h>
+#define BSP_INTREAD_REALLOC realloc
+#endif
+
+#ifndef BSP_INTREAD_FREE
+#include <stdlib.h>
+#define BSP_INTREAD_FREE free
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && defined(__GNUC__)
+#define __BSP_INTREAD_SWAR
+#endif
+
+__BSP_INTREAD_SCOPE
+Intreader*
+intreaderbuf(Intreader *r, char *buf, size_t len)
+{
+	r->buf = buf;
+	r->len = len;
+	r->p = buf;
+	r->e = buf + len;
+	r->mapped = 0;
+	r->owned = 0;
+	return r;
+}
+
+__BSP_INTREAD_SCOPE
+Intreader*
+intreaderinit(Intreader *r, int fd)
+{
+	struct stat st;
+	char *buf, *b;
+	size_t len, cap;
+	ssize_t n;
+
+	if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(buf != MAP_FAILED) {
+			posix_madvise(buf, st.st_size, POSIX_MADV_SEQUENTIAL);
+			intreaderbuf(r, buf, st.st_size);
+			r->mapped = 1;
+			return r;
+		}
+	}
+
+	buf = NULL;
+	len = 0;
+	cap = 0;
+	for(;;) {
+		if(len == cap) {
+			cap = 2*cap + (1<<16);
+			b = BSP_INTREAD_REALLOC(buf, cap);
+			if(b == NULL) {
+				BSP_INTREAD_FREE(buf);
+				return NULL;
+			}
+			buf = b;
+		}
+		n = read(fd, buf+len, cap-len);
+		if(n == 0) break;
+		if(n < 0) {
+			BSP_INTREAD_FREE(buf);
+			return NULL;
+		}
+		len += n;
+	}
+	intreaderbuf(r, buf, len);
+	r->owned = 1;
+	return r;
+}
+
+__BSP_INTREAD_SCOPE
+Intreader*
+intreaderfree(Intreader *r)
+{
+	if(r->mapped)
+		munmap(r->buf, r->len);
+	else if(r->owned)
+		BSP_INTREAD_FREE(r->buf);
+	intreaderbuf(r, NULL, 0);
+	return r;
+}
+
+#ifdef __BSP_INTREAD_SWAR
+static const uint32_t intreadpow10[8] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+};
+
+/*
+ * Convert the digits at p, of which there are at most eight, and
+ * return how many there were.
+ */
+static int
+swar8(char *p, uint32_t *v)
+{
+	uint64_t x, m;
+	int n;
+
+	*v = 0;
+	memcpy(&x, p, 8);
+	x ^= 0x3030303030303030ull;
+	m = ((x + 0x7676767676767676ull) | x) & 0x8080808080808080ull;
+	n = m == 0 ? 8 : __builtin_ctzll(m) >> 3;
+	if(n == 0) return 0;
+	// Zero bytes shifted in at the bottom are leading zeros.
+	x <<= 8*(8-n);
+	x = (x*10 + (x >> 8)) & 0x00ff00ff00ff00ffull;
+	x = (x*100 + (x >> 16)) & 0x0000ffff0000ffffull;
+	x = (x*10000 + (x >> 32)) & 0xffffffffull;
+	*v = x;
+	return n;
+}
+#endif
+
+__BSP_INTREAD_SCOPE
+int
+intread(Intreader *r, int *v)
+{
+	char *p, *e;
+	unsigned x;
+	int neg;
+#ifdef __BSP_INTREAD_SWAR
+	uint32_t y;
+	int n;
+#endif
+
+	p = r->p;
+	e = r->e;
+	for(;;) {
+		if(p == e) {
+			r->p = p;
+			return 0;
+		}
+		if((unsigned)(*p - '0') < 10) break;
+		if(*p == '-' && p+1 < e && (unsigned)(p[1] - '0') < 10) break;
+		p++;
+	}
+
+	neg = *p == '-';
+	p += neg;
+	x = 0;
+#ifdef __BSP_INTREAD_SWAR
+	while(e - p >= 8) {
+		n = swar8(p, &y);
+		p += n;
+		if(n < 8) {
+			x = x*intreadpow10[n] + y;
+			goto Done;
+		}
+		x = x*100000000u + y;
+	}
+#endif
+	while(p < e && (unsigned)(*p - '0') < 10)
+		x = x*10 + (*p++ - '0');
+#ifdef __BSP_INTREAD_SWAR
+Done:
+#endif
+	r->p = p;
+	*v = neg ? -(long long)x : (long long)x;
+	return 1;
+}
+
+#ifdef __BSP_INTREAD_SWAR
+#undef __BSP_INTREAD_SWAR
+#endif
+
+#endif // BSP_INTREAD_IMPLEMENTATION
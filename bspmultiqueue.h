@@ -0,0 +1,308 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a relaxed concurrent priority queue, a MultiQueue, with
+dependencies on POSIX threads, C11 atomics and ANSI C compatible calloc
+and free routines.
+
+Do this:
+	#define BSP_MULTIQUEUE_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_MULTIQUEUE_IMPLEMENTATION
+#include "bspmultiqueue.h"
+
+You can #define BSP_MULTIQUEUE_STATIC before the #include to keep everything
+private to one compilation unit. And #define BSP_MULTIQUEUE_CALLOC, and
+BSP_MULTIQUEUE_FREE to avoid using using calloc, and free. #define
+BSP_MULTIQUEUE_C to change the number of sub-heaps per thread from the
+default of 2.
+
+Embed an Mqnode as the first member of a structure, initialize a
+Multiqueue with mqinit, a comparison function and the number of threads
+that will use it, and pass pointers to the Mqnode member to the
+routines. The comparison function has the same meaning as for a Fibheap.
+
+	Multiqueue *mqinit(Multiqueue *mq, Mqcmp cmp, int nthreads);
+	Multiqueue *mqfree(Multiqueue *mq);
+	void        mqinsert(Multiqueue *mq, Mqnode *node);
+	Mqnode     *mqdeletemin(Multiqueue *mq);
+
+The queue is BSP_MULTIQUEUE_C*nthreads pairing heaps, each behind its
+own mutex. Mqinsert puts the node in a random sub-heap whose lock it can
+take without waiting. Mqdeletemin samples two sub-heaps, removes the
+minimum of the one with the smaller minimum and returns it. The node
+returned is therefore close to, but not always, the global minimum. When
+the samples keep coming up empty or locked it falls back to scanning
+every sub-heap, and it returns NULL only if that scan finds them all
+empty.
+
+Mqinit returns NULL if it cannot allocate the sub-heaps. Mqfree releases
+them but not the nodes still in the queue. The links of a node are in
+its Mqnode, so a node may be in the queue only once and its key must not
+change while it is queued. There is no decrease-key. A search that
+needs one should queue a separate entry for each insertion, holding the
+key it was queued with and a pointer to its node, and skip the entries
+whose key is out of date as they come out. The two sampled minima are
+compared without holding their locks, so the comparison function may be
+handed a node that another thread is in the middle of removing and may
+then give a new key. Nodes must stay valid for as long as the queue is
+in use, and a key that can change once its node is out of the queue
+must be written and read by the comparison function with atomics.
+
+See Rihani, Sanders and Dementiev. 2015. MultiQueues: Simple relaxed
+concurrent priority queues. SPAA '15, 80-82.
+*/
+
+#ifdef BSP_MULTIQUEUE_STATIC
+#define __BSP_MULTIQUEUE_SCOPE static
+#else
+#define __BSP_MULTIQUEUE_SCOPE
+#endif
+
+#ifndef __BSP_MULTIQUEUE_H_INCLUDE
+#define __BSP_MULTIQUEUE_H_INCLUDE
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Multiqueue Multiqueue;
+typedef struct Mqnode Mqnode;
+typedef struct Mqsub Mqsub;
+typedef int (*Mqcmp)(Mqnode*, Mqnode*);
+
+struct Multiqueue {
+	Mqcmp cmp;
+	Mqsub *q;
+	int nq;
+};
+
+// The padding keeps neighbouring sub-heaps off each other's cache lines.
+struct Mqsub {
+	pthread_mutex_t lk;
+	Mqnode *_Atomic min;
+	char pad[64];
+};
+
+struct Mqnode {
+	Mqnode *c, *next;
+};
+
+__BSP_MULTIQUEUE_SCOPE Multiqueue *mqinit(Multiqueue*, Mqcmp, int);
+__BSP_MULTIQUEUE_SCOPE Multiqueue *mqfree(Multiqueue*);
+__BSP_MULTIQUEUE_SCOPE void        mqinsert(Multiqueue*, Mqnode*);
+__BSP_MULTIQUEUE_SCOPE Mqnode     *mqdeletemin(Multiqueue*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_MULTIQUEUE_H_INCLUDE
+
+#ifdef BSP_MULTIQUEUE_IMPLEMENTATION
+
+#ifndef BSP_MULTIQUEUE_CALLOC
+#include <stdlib.h>
+#define BSP_MULTIQUEUE_CALLOC calloc
+#endif
+
+#ifndef BSP_MULTIQUEUE_FREE
+#include <stdlib.h>
+#define BSP_MULTIQUEUE_FREE free
+#endif
+
+#ifndef BSP_MULTIQUEUE_C
+#define BSP_MULTIQUEUE_C 2
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+	MQTRIES = 8,
+};
+
+static _Thread_local uint64_t mqstate;
+static atomic_uint_fast64_t mqseed;
+
+// Xorshift64*, seeded per thread on first use.
+static uint32_t
+mqrand(void)
+{
+	uint64_t x;
+
+	x = mqstate;
+	if(x == 0) {
+		x = atomic_fetch_add(&mqseed, 1) + 1;
+		x = (x ^ (uintptr_t)&mqstate) * 0x9e3779b97f4a7c15ull;
+		if(x == 0) x = 1;
+	}
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	mqstate = x;
+	return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+__BSP_MULTIQUEUE_SCOPE
+Multiqueue*
+mqinit(Multiqueue *mq, Mqcmp cmp, int nthreads)
+{
+	int i;
+
+	if(nthreads < 1) nthreads = 1;
+	mq->cmp = cmp;
+	mq->nq = BSP_MULTIQUEUE_C * nthreads;
+	mq->q = BSP_MULTIQUEUE_CALLOC(mq->nq, sizeof(*mq->q));
+	if(mq->q == NULL) return NULL;
+	for(i = 0; i < mq->nq; i++) {
+		pthread_mutex_init(&mq->q[i].lk, NULL);
+		atomic_init(&mq->q[i].min, NULL);
+	}
+	return mq;
+}
+
+__BSP_MULTIQUEUE_SCOPE
+Multiqueue*
+mqfree(Multiqueue *mq)
+{
+	int i;
+
+	for(i = 0; i < mq->nq; i++)
+		pthread_mutex_destroy(&mq->q[i].lk);
+	BSP_MULTIQUEUE_FREE(mq->q);
+	mq->q = NULL;
+	mq->nq = 0;
+	return mq;
+}
+
+static Mqnode*
+mqlink(Mqnode *x, Mqnode *y, Mqcmp cmp)
+{
+	Mqnode *t;
+
+	if(cmp(y, x) < 0) {
+		t = x;
+		x = y;
+		y = t;
+	}
+	y->next = x->c;
+	x->c = y;
+	x->next = NULL;
+	return x;
+}
+
+// Two pass pairing of a sibling list, as in bsppairheap.h.
+static Mqnode*
+mqcombine(Mqnode *n, Mqcmp cmp)
+{
+	Mqnode *m, *next, *stack;
+
+	stack = NULL;
+	while(n != NULL) {
+		m = n->next;
+		if(m == NULL) {
+			n->next = stack;
+			stack = n;
+			break;
+		}
+		next = m->next;
+		n = mqlink(n, m, cmp);
+		n->next = stack;
+		stack = n;
+		n = next;
+	}
+
+	if(stack == NULL) return NULL;
+	n = stack;
+	stack = stack->next;
+	while(stack != NULL) {
+		next = stack->next;
+		n = mqlink(stack, n, cmp);
+		stack = next;
+	}
+	n->next = NULL;
+	return n;
+}
+
+// Called with s->lk held.
+static Mqnode*
+mqpop(Multiqueue *mq, Mqsub *s)
+{
+	Mqnode *min;
+
+	min = atomic_load_explicit(&s->min, memory_order_relaxed);
+	if(min == NULL) return NULL;
+	atomic_store_explicit(&s->min, mqcombine(min->c, mq->cmp), memory_order_release);
+	min->c = NULL;
+	return min;
+}
+
+__BSP_MULTIQUEUE_SCOPE
+void
+mqinsert(Multiqueue *mq, Mqnode *n)
+{
+	Mqsub *s;
+	Mqnode *min;
+	int i;
+
+	n->c = NULL;
+	n->next = NULL;
+	for(i = 0;; i++) {
+		s = &mq->q[mqrand() % mq->nq];
+		if(pthread_mutex_trylock(&s->lk) == 0) break;
+		if(i == MQTRIES) {
+			pthread_mutex_lock(&s->lk);
+			break;
+		}
+	}
+	min = atomic_load_explicit(&s->min, memory_order_relaxed);
+	if(min != NULL) n = mqlink(min, n, mq->cmp);
+	atomic_store_explicit(&s->min, n, memory_order_release);
+	pthread_mutex_unlock(&s->lk);
+}
+
+__BSP_MULTIQUEUE_SCOPE
+Mqnode*
+mqdeletemin(Multiqueue *mq)
+{
+	Mqsub *s, *t;
+	Mqnode *a, *b, *n;
+	int i, j;
+
+	for(i = 0; i < MQTRIES; i++) {
+		s = &mq->q[mqrand() % mq->nq];
+		t = &mq->q[mqrand() % mq->nq];
+		a = atomic_load_explicit(&s->min, memory_order_acquire);
+		b = atomic_load_explicit(&t->min, memory_order_acquire);
+		if(a == NULL && b == NULL) continue;
+		if(a == NULL || (b != NULL && mq->cmp(b, a) < 0)) s = t;
+		if(pthread_mutex_trylock(&s->lk) != 0) continue;
+		n = mqpop(mq, s);
+		pthread_mutex_unlock(&s->lk);
+		if(n != NULL) return n;
+	}
+
+	j = mqrand() % mq->nq;
+	for(i = 0; i < mq->nq; i++) {
+		s = &mq->q[(i+j) % mq->nq];
+		if(atomic_load_explicit(&s->min, memory_order_relaxed) == NULL) continue;
+		pthread_mutex_lock(&s->lk);
+		n = mqpop(mq, s);
+		pthread_mutex_unlock(&s->lk);
+		if(n != NULL) return n;
+	}
+	return NULL;
+}
+
+#endif // BSP_MULTIQUEUE_IMPLEMENTATION
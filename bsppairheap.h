@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a no memory allocation pairing heap with no dependencies.
+
+Do this:
+	#define BSP_PAIRHEAP_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_PAIRHEAP_IMPLEMENTATION
+#include "bsppairheap.h"
+
+You can #define BSP_PAIRHEAP_STATIC before the #include to keep everything
+private to one compilation unit.
+
+The interface follows bspfibheap.h. Embed a Pairnode as the first member
+of a structure, initialize a Pairheap with pairinit and a comparison
+function, and pass pointers to the Pairnode member to the routines.
+
+	Pairheap *pairinit(Pairheap *heap, Paircmp cmp);
+	Pairheap *pairmeld(Pairheap *h1, Pairheap *h2);
+	void      pairinsert(Pairheap *heap, Pairnode *node);
+	void      pairdeletemin(Pairheap *heap);
+	void      pairdecreasekey(Pairheap *heap, Pairnode *node);
+	void      pairdelete(Pairheap *heap, Pairnode *node);
+
+The comparison function has the same meaning as for a Fibheap and the
+minimum element is kept in the min member of the heap, NULL when the
+heap is empty. Pairmeld moves every node of h2 into h1. None of the
+routines allocate so, unlike their Fibheap counterparts, they cannot
+fail.
+
+A pairing heap keeps a single tree. Each node points to its first child,
+its next sibling and, in prev, either its previous sibling or, for a
+first child, its parent. Deletemin combines the children of the root
+with the usual two pass pairing.
+
+See Fredman, Sedgewick, Sleator and Tarjan. 1986. The pairing heap: A new
+form of self-adjusting heap. Algorithmica 1, 111-129.
+*/
+
+#ifdef BSP_PAIRHEAP_STATIC
+#define __BSP_PAIRHEAP_SCOPE static
+#else
+#define __BSP_PAIRHEAP_SCOPE
+#endif
+
+#ifndef __BSP_PAIRHEAP_H_INCLUDE
+#define __BSP_PAIRHEAP_H_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Pairheap Pairheap;
+typedef struct Pairnode Pairnode;
+typedef int (*Paircmp)(Pairnode*, Pairnode*);
+
+struct Pairheap {
+	Paircmp cmp;
+	Pairnode *min;
+};
+
+struct Pairnode {
+	Pairnode *c, *next, *prev;
+};
+
+__BSP_PAIRHEAP_SCOPE Pairheap *pairinit(Pairheap*, Paircmp);
+__BSP_PAIRHEAP_SCOPE Pairheap *pairmeld(Pairheap*, Pairheap*);
+__BSP_PAIRHEAP_SCOPE void      pairinsert(Pairheap*, Pairnode*);
+__BSP_PAIRHEAP_SCOPE void      pairdeletemin(Pairheap*);
+__BSP_PAIRHEAP_SCOPE void      pairdecreasekey(Pairheap*, Pairnode*);
+__BSP_PAIRHEAP_SCOPE void      pairdelete(Pairheap*, Pairnode*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_PAIRHEAP_H_INCLUDE
+
+#ifdef BSP_PAIRHEAP_IMPLEMENTATION
+
+#include <stddef.h>
+
+__BSP_PAIRHEAP_SCOPE
+Pairheap*
+pairinit(Pairheap *h, Paircmp cmp)
+{
+	h->cmp = cmp;
+	h->min = NULL;
+	return h;
+}
+
+static Pairnode*
+pairlink(Pairnode *x, Pairnode *y, Paircmp cmp)
+{
+	Pairnode *t;
+
+	if(cmp(y, x) < 0) {
+		t = x;
+		x = y;
+		y = t;
+	}
+	y->next = x->c;
+	if(x->c != NULL) x->c->prev = y;
+	y->prev = x;
+	x->c = y;
+	x->next = NULL;
+	x->prev = NULL;
+	return x;
+}
+
+static Pairnode*
+pairmeld1(Pairnode *x, Pairnode *y, Paircmp cmp)
+{
+	if(x == NULL) return y;
+	if(y == NULL) return x;
+	return pairlink(x, y, cmp);
+}
+
+__BSP_PAIRHEAP_SCOPE
+Pairheap*
+pairmeld(Pairheap *h1, Pairheap *h2)
+{
+	h1->min = pairmeld1(h1->min, h2->min, h1->cmp);
+	h2->min = NULL;
+	return h1;
+}
+
+__BSP_PAIRHEAP_SCOPE
+void
+pairinsert(Pairheap *h, Pairnode *n)
+{
+	n->c = NULL;
+	n->next = NULL;
+	n->prev = NULL;
+	h->min = pairmeld1(h->min, n, h->cmp);
+}
+
+/*
+ * Two pass pairing of a sibling list. The first pass links
+ * neighbours left to right and stacks the results through next,
+ * the second pass links the stack back into one tree.
+ */
+static Pairnode*
+combine(Pairnode *n, Paircmp cmp)
+{
+	Pairnode *m, *next, *stack;
+
+	stack = NULL;
+	while(n != NULL) {
+		m = n->next;
+		if(m == NULL) {
+			n->next = stack;
+			stack = n;
+			break;
+		}
+		next = m->next;
+		n = pairlink(n, m, cmp);
+		n->next = stack;
+		stack = n;
+		n = next;
+	}
+
+	if(stack == NULL) return NULL;
+	n = stack;
+	stack = stack->next;
+	while(stack != NULL) {
+		next = stack->next;
+		n = pairlink(stack, n, cmp);
+		stack = next;
+	}
+	n->next = NULL;
+	n->prev = NULL;
+	return n;
+}
+
+__BSP_PAIRHEAP_SCOPE
+void
+pairdeletemin(Pairheap *h)
+{
+	Pairnode *min;
+
+	min = h->min;
+	if(min == NULL) return;
+	h->min = combine(min->c, h->cmp);
+	min->c = NULL;
+}
+
+static void
+detach(Pairnode *n)
+{
+	if(n->prev->c == n)
+		n->prev->c = n->next;
+	else
+		n->prev->next = n->next;
+	if(n->next != NULL) n->next->prev = n->prev;
+	n->next = NULL;
+	n->prev = NULL;
+}
+
+__BSP_PAIRHEAP_SCOPE
+void
+pairdecreasekey(Pairheap *h, Pairnode *n)
+{
+	if(n == h->min) return;
+	detach(n);
+	h->min = pairlink(h->min, n, h->cmp);
+}
+
+__BSP_PAIRHEAP_SCOPE
+void
+pairdelete(Pairheap *h, Pairnode *n)
+{
+	if(n == h->min) {
+		pairdeletemin(h);
+		return;
+	}
+	detach(n);
+	h->min = pairmeld1(h->min, combine(n->c, h->cmp), h->cmp);
+	n->c = NULL;
+}
+
+#endif // BSP_PAIRHEAP_IMPLEMENTATION
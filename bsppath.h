@@ -0,0 +1,410 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a point to point shortest path search over the graphs of
+bspgraph.h, using the heaps of bspfibheap.h, with dependencies on ANSI
+C compatible calloc and free routines.
+
+Do this:
+	#define BSP_PATH_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_PATH_IMPLEMENTATION
+#include "bsppath.h"
+
+Include bspfibheap.h and bspgraph.h before this file; their
+implementations must be created in some C file as well. You can #define
+BSP_PATH_STATIC before the #include to keep everything private to one
+compilation unit. And #define BSP_PATH_CALLOC, and BSP_PATH_FREE to
+avoid using using calloc, and free.
+
+	Pathfinder *pathinit(Pathfinder *pf, Graph *g, Graph *rev);
+	Pathfinder *pathfree(Pathfinder *pf);
+	long long   pathbidir(Pathfinder *pf, int s, int t);
+	long long   pathastar(Pathfinder *pf, int s, int t, Pathheur h, void *aux);
+	int         pathfrom(Pathfinder *pf, int s);
+	long long   pathdist(Pathfinder *pf, int v);
+	int         pathroute(Pathfinder *pf, int *route, int max);
+
+Pathinit allocates the search state for the nodes of g and returns NULL
+if it cannot. Rev must hold the arcs of g reversed, built by passing
+graphbuild the edges with s and d swapped, and may be g itself when g
+was built with GRAPHUNDIRECTED. Arc weights must not be negative.
+
+Pathbidir returns the length of a shortest path from s to t found by
+searching forward from s over g and backward from t over rev at once,
+each with its own Fibheap, always advancing the search whose minimum is
+smaller. Every arc scanned that reaches a node seen by the other search
+is a candidate path, and the search stops once the two minima together
+are no shorter than the best candidate, since no path through an
+unsettled node can then be shorter.
+
+Pathastar returns the same length searching forward from s alone with
+each node keyed by its distance plus h(v, aux), a lower bound on the
+distance from v to t, and stops when t leaves the heap. The bound need
+only be admissible: a node reached again by a shorter path after it was
+settled is put back in the heap. A heuristic that always returns 0
+makes it Dijkstra's algorithm stopped early, and so does passing NULL.
+
+Both return -1 if t cannot be reached and -2 if a heap operation fails
+to allocate. Pathfrom searches from s to every node it can reach and
+returns how many that was, or -2. After a search the nsettled member
+holds the number of nodes removed from the heaps, and pathdist returns
+the distance from s to v if the forward search settled v and -1 if it
+did not, which after pathastar with a heuristic that is admissible but
+not consistent may be longer than the shortest. Pathroute stores in
+route up to max of the nodes of the path found, from s to t, and
+returns the number of nodes on the path, 0 if there is none.
+
+A Pathfinder is meant to answer many queries on one graph. Each node
+carries the number of the search that last touched it, and a node whose
+number is not that of the current search counts as unseen, so starting
+a search does not clear the nodes and a query costs time in proportion
+to the nodes it reaches rather than to the size of the graph. The nodes
+are cleared once each time the 32 bit search number wraps around.
+*/
+
+#ifdef BSP_PATH_STATIC
+#define __BSP_PATH_SCOPE static
+#else
+#define __BSP_PATH_SCOPE
+#endif
+
+#ifndef __BSP_PATH_H_INCLUDE
+#define __BSP_PATH_H_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Pathfinder Pathfinder;
+typedef struct Pathnode Pathnode;
+typedef long long (*Pathheur)(int, void*);
+
+enum {
+	PATHUNSEEN,
+	PATHQUEUED,
+	PATHSETTLED,
+};
+
+struct Pathnode {
+	Fibnode fib;
+	long long dist;
+	long long key;
+	int pred;
+	int state;
+	unsigned gen;
+};
+
+struct Pathfinder {
+	Graph *g, *rev;
+	Pathnode *fwd, *bwd;
+	Fibheap fh, bh;
+	int s, t, meet;
+	long long dist;
+	int nsettled;
+	unsigned epoch;
+};
+
+__BSP_PATH_SCOPE Pathfinder *pathinit(Pathfinder*, Graph*, Graph*);
+__BSP_PATH_SCOPE Pathfinder *pathfree(Pathfinder*);
+__BSP_PATH_SCOPE long long   pathbidir(Pathfinder*, int, int);
+__BSP_PATH_SCOPE long long   pathastar(Pathfinder*, int, int, Pathheur, void*);
+__BSP_PATH_SCOPE int         pathfrom(Pathfinder*, int);
+__BSP_PATH_SCOPE long long   pathdist(Pathfinder*, int);
+__BSP_PATH_SCOPE int         pathroute(Pathfinder*, int*, int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_PATH_H_INCLUDE
+
+#ifdef BSP_PATH_IMPLEMENTATION
+
+#ifndef BSP_PATH_CALLOC
+#include <stdlib.h>
+#define BSP_PATH_CALLOC calloc
+#endif
+
+#ifndef BSP_PATH_FREE
+#include <stdlib.h>
+#define BSP_PATH_FREE free
+#endif
+
+#include <limits.h>
+
+static int
+pathcmp(Fibnode *a, Fibnode *b)
+{
+	Pathnode *x, *y;
+
+	x = (Pathnode*)a;
+	y = (Pathnode*)b;
+	if(x->key < y->key) return -1;
+	if(x->key > y->key) return 1;
+	return 0;
+}
+
+__BSP_PATH_SCOPE
+Pathfinder*
+pathinit(Pathfinder *pf, Graph *g, Graph *rev)
+{
+	pf->g = g;
+	pf->rev = rev;
+	pf->fwd = BSP_PATH_CALLOC(g->nnodes, sizeof(*pf->fwd));
+	pf->bwd = BSP_PATH_CALLOC(g->nnodes, sizeof(*pf->bwd));
+	if(pf->fwd == NULL || pf->bwd == NULL) {
+		BSP_PATH_FREE(pf->fwd);
+		BSP_PATH_FREE(pf->bwd);
+		return NULL;
+	}
+	fibinit(&pf->fh, pathcmp);
+	fibinit(&pf->bh, pathcmp);
+	pf->s = pf->t = pf->meet = -1;
+	pf->dist = -1;
+	pf->nsettled = 0;
+	pf->epoch = 0;
+	return pf;
+}
+
+__BSP_PATH_SCOPE
+Pathfinder*
+pathfree(Pathfinder *pf)
+{
+	BSP_PATH_FREE(pf->fwd);
+	BSP_PATH_FREE(pf->bwd);
+	pf->fwd = pf->bwd = NULL;
+	fibfree(&pf->fh);
+	fibfree(&pf->bh);
+	return pf;
+}
+
+static void
+pathreset(Pathfinder *pf, int s, int t)
+{
+	int i;
+
+	if(++pf->epoch == 0) {
+		for(i = 0; i < pf->g->nnodes; i++)
+			pf->fwd[i].gen = pf->bwd[i].gen = 0;
+		pf->epoch = 1;
+	}
+	/*
+	 * Nodes left behind by the last search are abandoned with the
+	 * root lists. The consolidation arrays are all NULL between heap
+	 * operations, so they are kept as they are for the next search.
+	 */
+	pf->fh.min = NULL;
+	pf->bh.min = NULL;
+	pf->s = s;
+	pf->t = t;
+	pf->meet = -1;
+	pf->dist = -1;
+	pf->nsettled = 0;
+}
+
+// The state of n in the current search.
+static int
+pathstate(Pathfinder *pf, Pathnode *n)
+{
+	if(n->gen != pf->epoch) {
+		n->gen = pf->epoch;
+		n->state = PATHUNSEEN;
+	}
+	return n->state;
+}
+
+/*
+ * Give n distance d through pred if that is shorter, keyed d plus
+ * the part of its key that was not distance.
+ */
+static void
+pathrelax(Pathfinder *pf, Fibheap *h, Pathnode *n, int pred, long long d, long long bound)
+{
+	switch(pathstate(pf, n)) {
+	case PATHUNSEEN:
+		n->dist = d;
+		n->key = d + bound;
+		n->pred = pred;
+		n->state = PATHQUEUED;
+		fibinsert(h, &n->fib);
+		break;
+	case PATHQUEUED:
+		if(d >= n->dist) break;
+		n->key = d + n->key - n->dist;
+		n->dist = d;
+		n->pred = pred;
+		fibdecreasekey(h, &n->fib);
+		break;
+	case PATHSETTLED:
+		if(d >= n->dist) break;
+		n->key = d + n->key - n->dist;
+		n->dist = d;
+		n->pred = pred;
+		n->state = PATHQUEUED;
+		fibinsert(h, &n->fib);
+		break;
+	}
+}
+
+static Pathnode*
+pathpop(Pathfinder *pf, Fibheap *h)
+{
+	Pathnode *n;
+
+	n = (Pathnode*)h->min;
+	if(fibdeletemin(h) < 0) return NULL;
+	n->state = PATHSETTLED;
+	pf->nsettled++;
+	return n;
+}
+
+__BSP_PATH_SCOPE
+long long
+pathbidir(Pathfinder *pf, int s, int t)
+{
+	Fibheap *h;
+	Pathnode *side, *other, *n, *m;
+	Grapharc *a, *end;
+	Graph *g;
+	long long mu, d;
+	int u;
+
+	pathreset(pf, s, t);
+	pathrelax(pf, &pf->fh, &pf->fwd[s], -1, 0, 0);
+	pathrelax(pf, &pf->bh, &pf->bwd[t], -1, 0, 0);
+	mu = LLONG_MAX;
+	if(s == t) {
+		mu = 0;
+		pf->meet = s;
+	}
+
+	while(pf->fh.min != NULL && pf->bh.min != NULL) {
+		if(((Pathnode*)pf->fh.min)->key + ((Pathnode*)pf->bh.min)->key >= mu)
+			break;
+		if(pathcmp(pf->fh.min, pf->bh.min) <= 0) {
+			h = &pf->fh;
+			g = pf->g;
+			side = pf->fwd;
+			other = pf->bwd;
+		} else {
+			h = &pf->bh;
+			g = pf->rev;
+			side = pf->bwd;
+			other = pf->fwd;
+		}
+		n = pathpop(pf, h);
+		if(n == NULL) return -2;
+		u = n - side;
+		end = g->arcs + g->off[u+1];
+		for(a = g->arcs + g->off[u]; a < end; a++) {
+			m = side + a->d;
+			pathrelax(pf, h, m, u, n->dist + a->w, 0);
+			if(pathstate(pf, &other[a->d]) == PATHUNSEEN) continue;
+			d = m->dist + other[a->d].dist;
+			if(d < mu) {
+				mu = d;
+				pf->meet = a->d;
+			}
+		}
+	}
+
+	if(mu == LLONG_MAX) return -1;
+	pf->dist = mu;
+	return mu;
+}
+
+/*
+ * Search forward from s until t is settled, or until the heap is
+ * empty if t is -1.
+ */
+static long long
+pathforward(Pathfinder *pf, int s, int t, Pathheur h, void *aux)
+{
+	Pathnode *n, *m;
+	Grapharc *a, *end;
+	Graph *g;
+	int u;
+
+	pathreset(pf, s, t);
+	g = pf->g;
+	pathrelax(pf, &pf->fh, &pf->fwd[s], -1, 0, h != NULL ? h(s, aux) : 0);
+	while(pf->fh.min != NULL) {
+		n = pathpop(pf, &pf->fh);
+		if(n == NULL) return -2;
+		u = n - pf->fwd;
+		if(u == t) {
+			pf->meet = t;
+			pf->dist = n->dist;
+			return n->dist;
+		}
+		end = g->arcs + g->off[u+1];
+		for(a = g->arcs + g->off[u]; a < end; a++) {
+			m = pf->fwd + a->d;
+			if(h != NULL && pathstate(pf, m) == PATHUNSEEN)
+				pathrelax(pf, &pf->fh, m, u, n->dist + a->w, h(a->d, aux));
+			else
+				pathrelax(pf, &pf->fh, m, u, n->dist + a->w, 0);
+		}
+	}
+	return -1;
+}
+
+__BSP_PATH_SCOPE
+long long
+pathastar(Pathfinder *pf, int s, int t, Pathheur h, void *aux)
+{
+	return pathforward(pf, s, t, h, aux);
+}
+
+__BSP_PATH_SCOPE
+int
+pathfrom(Pathfinder *pf, int s)
+{
+	if(pathforward(pf, s, -1, NULL, NULL) == -2) return -2;
+	return pf->nsettled;
+}
+
+__BSP_PATH_SCOPE
+long long
+pathdist(Pathfinder *pf, int v)
+{
+	Pathnode *n;
+
+	n = &pf->fwd[v];
+	if(n->gen != pf->epoch || n->state != PATHSETTLED) return -1;
+	return n->dist;
+}
+
+__BSP_PATH_SCOPE
+int
+pathroute(Pathfinder *pf, int *route, int max)
+{
+	int len, i, v;
+
+	if(pf->meet < 0) return 0;
+
+	// Count the nodes from s to meet, then fill them in backwards.
+	len = 0;
+	for(v = pf->meet; v != -1; v = pf->fwd[v].pred)
+		len++;
+	i = len;
+	for(v = pf->meet; v != -1; v = pf->fwd[v].pred) {
+		if(--i < max) route[i] = v;
+	}
+	if(pf->meet == pf->t) return len;
+	for(v = pf->bwd[pf->meet].pred; v != -1; v = pf->bwd[v].pred) {
+		if(len < max) route[len] = v;
+		len++;
+	}
+	return len;
+}
+
+#endif // BSP_PATH_IMPLEMENTATION
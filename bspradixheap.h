@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a no memory allocation monotone radix heap with no dependencies.
+
+Do this:
+	#define BSP_RADIXHEAP_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_RADIXHEAP_IMPLEMENTATION
+#include "bspradixheap.h"
+
+You can #define BSP_RADIXHEAP_STATIC before the #include to keep everything
+private to one compilation unit.
+
+A radix heap is a priority queue for unsigned integer keys where no key
+inserted is smaller than the last key removed, as is the case for the
+distances in Dijkstra's algorithm. Embed a Radixnode as the first member
+of a structure and pass pointers to it to the routines.
+
+	Radixheap *radixinit(Radixheap *heap);
+	void       radixinsert(Radixheap *heap, Radixnode *node, uint64_t key);
+	Radixnode *radixmin(Radixheap *heap);
+	Radixnode *radixdeletemin(Radixheap *heap);
+	void       radixdecreasekey(Radixheap *heap, Radixnode *node, uint64_t key);
+	void       radixdelete(Radixheap *heap, Radixnode *node);
+
+The key of a node is kept in its key member and must only be changed
+through radixdecreasekey. Radixmin returns a node with the minimum key,
+or NULL if the heap is empty, and radixdeletemin removes and returns it.
+Keys passed to radixinsert and radixdecreasekey must not be less than
+the key of the node last returned by radixmin.
+
+Bucket 0 holds the nodes whose key equals the last minimum and bucket i
+the nodes whose key first differs from it at bit i-1. Finding a new
+minimum empties the lowest non-empty bucket into lower ones, so each
+node moves at most 64 times over its life in the heap.
+
+See Ahuja, Mehlhorn, Orlin and Tarjan. 1990. Faster algorithms for the
+shortest path problem. J. ACM 37, 2, 213-223.
+*/
+
+#ifdef BSP_RADIXHEAP_STATIC
+#define __BSP_RADIXHEAP_SCOPE static
+#else
+#define __BSP_RADIXHEAP_SCOPE
+#endif
+
+#ifndef __BSP_RADIXHEAP_H_INCLUDE
+#define __BSP_RADIXHEAP_H_INCLUDE
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Radixheap Radixheap;
+typedef struct Radixnode Radixnode;
+
+enum {
+	RADIXNBKT = 65,
+};
+
+struct Radixheap {
+	Radixnode *bkt[RADIXNBKT];
+	uint64_t last;
+};
+
+struct Radixnode {
+	Radixnode *next, *prev;
+	uint64_t key;
+	int bkt;
+};
+
+__BSP_RADIXHEAP_SCOPE Radixheap *radixinit(Radixheap*);
+__BSP_RADIXHEAP_SCOPE void       radixinsert(Radixheap*, Radixnode*, uint64_t);
+__BSP_RADIXHEAP_SCOPE Radixnode *radixmin(Radixheap*);
+__BSP_RADIXHEAP_SCOPE Radixnode *radixdeletemin(Radixheap*);
+__BSP_RADIXHEAP_SCOPE void       radixdecreasekey(Radixheap*, Radixnode*, uint64_t);
+__BSP_RADIXHEAP_SCOPE void       radixdelete(Radixheap*, Radixnode*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_RADIXHEAP_H_INCLUDE
+
+#ifdef BSP_RADIXHEAP_IMPLEMENTATION
+
+#include <stddef.h>
+
+__BSP_RADIXHEAP_SCOPE
+Radixheap*
+radixinit(Radixheap *h)
+{
+	int i;
+
+	for(i = 0; i < RADIXNBKT; i++)
+		h->bkt[i] = NULL;
+	h->last = 0;
+	return h;
+}
+
+static int
+bucket(uint64_t last, uint64_t key)
+{
+	uint64_t x;
+	int b;
+
+	x = key ^ last;
+	if(x == 0) return 0;
+#ifdef __GNUC__
+	b = 64 - __builtin_clzll(x);
+#else
+	for(b = 0; x != 0; b++)
+		x >>= 1;
+#endif
+	return b;
+}
+
+static void
+push(Radixheap *h, Radixnode *n, int b)
+{
+	n->bkt = b;
+	n->prev = NULL;
+	n->next = h->bkt[b];
+	if(n->next != NULL) n->next->prev = n;
+	h->bkt[b] = n;
+}
+
+static void
+unlink1(Radixheap *h, Radixnode *n)
+{
+	if(n->prev != NULL)
+		n->prev->next = n->next;
+	else
+		h->bkt[n->bkt] = n->next;
+	if(n->next != NULL) n->next->prev = n->prev;
+}
+
+__BSP_RADIXHEAP_SCOPE
+void
+radixinsert(Radixheap *h, Radixnode *n, uint64_t key)
+{
+	n->key = key;
+	push(h, n, bucket(h->last, key));
+}
+
+__BSP_RADIXHEAP_SCOPE
+Radixnode*
+radixmin(Radixheap *h)
+{
+	Radixnode *n, *next;
+	uint64_t min;
+	int i;
+
+	if(h->bkt[0] != NULL) return h->bkt[0];
+
+	for(i = 1; i < RADIXNBKT; i++) {
+		if(h->bkt[i] != NULL) break;
+	}
+	if(i == RADIXNBKT) return NULL;
+
+	min = h->bkt[i]->key;
+	for(n = h->bkt[i]->next; n != NULL; n = n->next) {
+		if(n->key < min) min = n->key;
+	}
+	h->last = min;
+
+	n = h->bkt[i];
+	h->bkt[i] = NULL;
+	for(; n != NULL; n = next) {
+		next = n->next;
+		push(h, n, bucket(min, n->key));
+	}
+	return h->bkt[0];
+}
+
+__BSP_RADIXHEAP_SCOPE
+Radixnode*
+radixdeletemin(Radixheap *h)
+{
+	Radixnode *n;
+
+	n = radixmin(h);
+	if(n != NULL) unlink1(h, n);
+	return n;
+}
+
+__BSP_RADIXHEAP_SCOPE
+void
+radixdecreasekey(Radixheap *h, Radixnode *n, uint64_t key)
+{
+	int b;
+
+	n->key = key;
+	b = bucket(h->last, key);
+	if(b == n->bkt) return;
+	unlink1(h, n);
+	push(h, n, b);
+}
+
+__BSP_RADIXHEAP_SCOPE
+void
+radixdelete(Radixheap *h, Radixnode *n)
+{
+	unlink1(h, n);
+}
+
+#endif // BSP_RADIXHEAP_IMPLEMENTATION
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2017 Benjamin Scher Purcell <benjapurcell@gmail.com>
+and is licensed for use under the terms found at
+https://github.com/spewspews/bsp/blob/master/LICENSE
+
+This is a no memory allocation hierarchical timing wheel with no
+dependencies.
+
+Do this:
+	#define BSP_TIMERWHEEL_IMPLEMENTATION
+before you include this file in *one* C file to create the implementation.
+
+// i.e. it should look like this:
+#include ...
+#include ...
+#include ...
+#define BSP_TIMERWHEEL_IMPLEMENTATION
+#include "bsptimerwheel.h"
+
+You can #define BSP_TIMERWHEEL_STATIC before the #include to keep
+everything private to one compilation unit.
+
+A timing wheel holds timers that each expire at some unsigned integer
+time and hands them back once the clock passes it, taking constant time
+to add or cancel one. Unlike a heap it never orders timers that are
+cancelled before they expire. Embed a Timernode as the first member of
+a structure and pass pointers to it to the routines.
+
+	Timerwheel *timerinit(Timerwheel *wheel, uint64_t now);
+	void        timeradd(Timerwheel *wheel, Timernode *node, uint64_t when);
+	void        timercancel(Timerwheel *wheel, Timernode *node);
+	Timernode  *timerexpire(Timerwheel *wheel, uint64_t now);
+	uint64_t    timernext(Timerwheel *wheel);
+
+Timerinit starts the clock of the wheel at now. Timeradd schedules node
+to expire at when, which is kept in its when member, and a time not
+after the clock expires at the next call to timerexpire. A node must not
+be added again while it is in the wheel. Timercancel removes node if it
+is still in the wheel and does nothing if it has expired or was
+cancelled. Timerexpire moves the clock forward to now, which must not
+be before it, and returns one node whose time has come, or NULL when
+none is left, so
+
+	while((n = timerexpire(&wheel, now)) != NULL)
+		fire(n);
+
+runs every timer due by now. Nodes due at the same time come back in no
+particular order. Timernext returns a time no later than the next
+expiry, at which calling timerexpire will do some work, or UINT64_MAX if
+the wheel is empty.
+
+The wheel has TIMERNLEVEL levels of TIMERNSLOT slots, the slots of
+level l each covering 64^l units of time. A timer sits in the level of
+the highest 6 bit digit in which its time differs from the clock and in
+the slot of that digit, so every slot of a level holds timers later
+than the clock and those of the lowest level hold timers of one time.
+Moving the clock into the span of a slot above the lowest cascades its
+timers down into the levels below, which happens at most once per level
+for each timer. A bit map of the occupied slots of each level lets the
+clock skip empty spans at once.
+
+See Varghese and Lauck. 1987. Hashed and hierarchical timing wheels:
+data structures for the efficient implementation of a timer facility.
+SOSP '87, 25-38.
+*/
+
+#ifdef BSP_TIMERWHEEL_STATIC
+#define __BSP_TIMERWHEEL_SCOPE static
+#else
+#define __BSP_TIMERWHEEL_SCOPE
+#endif
+
+#ifndef __BSP_TIMERWHEEL_H_INCLUDE
+#define __BSP_TIMERWHEEL_H_INCLUDE
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Timerwheel Timerwheel;
+typedef struct Timernode Timernode;
+
+enum {
+	TIMERBITS = 6,
+	TIMERNSLOT = 1<<TIMERBITS,
+	TIMERNLEVEL = (64+TIMERBITS-1)/TIMERBITS,
+	TIMERDUE = TIMERNLEVEL*TIMERNSLOT,
+};
+
+struct Timerwheel {
+	Timernode *slot[TIMERDUE+1];
+	uint64_t occ[TIMERNLEVEL];
+	uint64_t now;
+};
+
+struct Timernode {
+	Timernode *next, *prev;
+	uint64_t when;
+	int slot;
+};
+
+__BSP_TIMERWHEEL_SCOPE Timerwheel *timerinit(Timerwheel*, uint64_t);
+__BSP_TIMERWHEEL_SCOPE void        timeradd(Timerwheel*, Timernode*, uint64_t);
+__BSP_TIMERWHEEL_SCOPE void        timercancel(Timerwheel*, Timernode*);
+__BSP_TIMERWHEEL_SCOPE Timernode  *timerexpire(Timerwheel*, uint64_t);
+__BSP_TIMERWHEEL_SCOPE uint64_t    timernext(Timerwheel*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __BSP_TIMERWHEEL_H_INCLUDE
+
+#ifdef BSP_TIMERWHEEL_IMPLEMENTATION
+
+#include <stddef.h>
+
+__BSP_TIMERWHEEL_SCOPE
+Timerwheel*
+timerinit(Timerwheel *w, uint64_t now)
+{
+	int i;
+
+	for(i = 0; i <= TIMERDUE; i++)
+		w->slot[i] = NULL;
+	for(i = 0; i < TIMERNLEVEL; i++)
+		w->occ[i] = 0;
+	w->now = now;
+	return w;
+}
+
+static int
+twlowbit(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	int b;
+
+	for(b = 0; (x & 1) == 0; b++)
+		x >>= 1;
+	return b;
+#endif
+}
+
+static int
+twhighbit(uint64_t x)
+{
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(x);
+#else
+	int b;
+
+	for(b = -1; x != 0; b++)
+		x >>= 1;
+	return b;
+#endif
+}
+
+static void
+twpush(Timerwheel *w, Timernode *n, int s)
+{
+	n->slot = s;
+	n->prev = NULL;
+	n->next = w->slot[s];
+	if(n->next != NULL) n->next->prev = n;
+	w->slot[s] = n;
+	if(s < TIMERDUE)
+		w->occ[s/TIMERNSLOT] |= 1ull << s%TIMERNSLOT;
+}
+
+static void
+twunlink(Timerwheel *w, Timernode *n)
+{
+	int s;
+
+	s = n->slot;
+	if(n->prev != NULL)
+		n->prev->next = n->next;
+	else
+		w->slot[s] = n->next;
+	if(n->next != NULL) n->next->prev = n->prev;
+	if(w->slot[s] == NULL && s < TIMERDUE)
+		w->occ[s/TIMERNSLOT] &= ~(1ull << s%TIMERNSLOT);
+	n->slot = -1;
+}
+
+// File n by the first digit in which its time differs from the clock.
+static void
+twfile(Timerwheel *w, Timernode *n)
+{
+	int l;
+
+	if(n->when <= w->now) {
+		twpush(w, n, TIMERDUE);
+		return;
+	}
+	l = twhighbit(n->when ^ w->now) / TIMERBITS;
+	twpush(w, n, l*TIMERNSLOT + (n->when >> l*TIMERBITS) % TIMERNSLOT);
+}
+
+__BSP_TIMERWHEEL_SCOPE
+void
+timeradd(Timerwheel *w, Timernode *n, uint64_t when)
+{
+	n->when = when;
+	twfile(w, n);
+}
+
+__BSP_TIMERWHEEL_SCOPE
+void
+timercancel(Timerwheel *w, Timernode *n)
+{
+	if(n->slot >= 0) twunlink(w, n);
+}
+
+/*
+ * The level of the earliest occupied slot, whose span starts at *t,
+ * or -1 if the wheel holds nothing but due timers.
+ */
+static int
+twnextslot(Timerwheel *w, uint64_t *t)
+{
+	uint64_t hi;
+	int l, d, sh;
+
+	for(l = 0; l < TIMERNLEVEL; l++) {
+		if(w->occ[l] != 0) break;
+	}
+	if(l == TIMERNLEVEL) return -1;
+	d = twlowbit(w->occ[l]);
+	sh = l*TIMERBITS;
+	hi = sh+TIMERBITS >= 64 ? 0 : w->now >> (sh+TIMERBITS) << (sh+TIMERBITS);
+	*t = hi | (uint64_t)d << sh;
+	return l;
+}
+
+__BSP_TIMERWHEEL_SCOPE
+Timernode*
+timerexpire(Timerwheel *w, uint64_t now)
+{
+	Timernode *n, *next;
+	uint64_t t;
+	int l;
+
+	for(;;) {
+		n = w->slot[TIMERDUE];
+		if(n != NULL) {
+			twunlink(w, n);
+			return n;
+		}
+		if(w->now == now) return NULL;
+		l = twnextslot(w, &t);
+		if(l == -1 || t > now) {
+			// Nothing is due before now, and no digit passes a slot.
+			w->now = now;
+			return NULL;
+		}
+		w->now = t;
+		n = w->slot[l*TIMERNSLOT + (t >> l*TIMERBITS) % TIMERNSLOT];
+		for(; n != NULL; n = next) {
+			next = n->next;
+			twunlink(w, n);
+			twfile(w, n);
+		}
+	}
+}
+
+__BSP_TIMERWHEEL_SCOPE
+uint64_t
+timernext(Timerwheel *w)
+{
+	uint64_t t;
+
+	if(w->slot[TIMERDUE] != NULL) return w->now;
+	if(twnextslot(w, &t) == -1) return UINT64_MAX;
+	return t;
+}
+
+#endif // BSP_TIMERWHEEL_IMPLEMENTATION
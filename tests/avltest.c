@@ -1,5 +1,6 @@
 #define _XOPEN_SOURCE
 #define BSP_AVL_IMPLEMENTATION
+#define BSP_AVL_SIZE
 #include "../bspavl.h"
 
 #include <assert.h>
@@ -13,10 +14,14 @@ struct Int {
 	int i;
 };
 
-Int pool[100];
-
 #define nelem(x) (sizeof(x)/sizeof(*x))
 
+Int pool[100];
+Int churn[1000];
+char present[nelem(churn)];
+Int seta[2000], setb[nelem(seta)];
+char ina[nelem(seta)], inb[nelem(seta)];
+
 int
 Intcmp(Avl *a, Avl *b)
 {
@@ -58,6 +63,263 @@ check(Avl *n)
 	b = dr - dl;
 	printf("Actual balance is %d\n", b);
 	assert(b == n->b);
+	assert(n->c[0] == NULL || n->c[0]->p == n);
+	assert(n->c[1] == NULL || n->c[1]->p == n);
+}
+
+// Check balance, parent links, sizes and order without printing.
+int
+verify(Avl *n, Avl *p)
+{
+	int dl, dr;
+
+	if(n == NULL)
+		return 0;
+	assert(n->p == p);
+	assert(n->c[0] == NULL || Intcmp(n->c[0], n) < 0);
+	assert(n->c[1] == NULL || Intcmp(n->c[1], n) > 0);
+	dl = verify(n->c[0], n);
+	dr = verify(n->c[1], n);
+	assert(dr - dl == n->b);
+	assert(n->n == 1 + (n->c[0] ? n->c[0]->n : 0) + (n->c[1] ? n->c[1]->n : 0));
+	return (dl > dr ? dl : dr) + 1;
+}
+
+// Rank, select and count against the table of what is in the tree.
+void
+ranktest(Avltree *t)
+{
+	Int *ip, lo, hi;
+	int i, j, r;
+
+	r = 0;
+	for(i = 0; i < (int)nelem(churn); i++) {
+		lo.i = i;
+		assert(avlrank(t, &lo.a) == r);
+		if(!present[i])
+			continue;
+		ip = (Int*)avlselect(t, r);
+		assert(ip == &churn[i]);
+		r++;
+	}
+	assert(avlselect(t, r) == NULL);
+	assert(avlselect(t, -1) == NULL);
+	for(i = 0; i < 1000; i++) {
+		lo.i = drand48()*nelem(churn);
+		hi.i = drand48()*nelem(churn);
+		r = 0;
+		for(j = lo.i; j < hi.i; j++)
+			r += present[j];
+		assert(avlcount(t, &lo.a, &hi.a) == r);
+	}
+	printf("Rank ok\n");
+}
+
+// Build trees of every size up to nelem(churn) from sorted nodes and flatten them back.
+void
+buildtest(void)
+{
+	static Avl *nodes[nelem(churn)], *out[nelem(churn)];
+	Avltree t;
+	Int d;
+	int i, n;
+
+	avlinit(&t, Intcmp);
+	for(n = 0; n <= (int)nelem(churn); n += n < 100 ? 1 : 97) {
+		for(i = 0; i < n; i++) {
+			churn[i].i = 2*i;
+			nodes[i] = &churn[i].a;
+		}
+		assert(avlbuild(&t, nodes, n) == &t);
+		verify(t.root, NULL);
+		assert(avlflatten(&t, out, nelem(out)) == n);
+		for(i = 0; i < n; i++)
+			assert(out[i] == nodes[i]);
+		assert(n < 2 || avlflatten(&t, out, n/2) == n/2);
+
+		// The tree must take updates like any other.
+		for(i = 0; i < n; i += 3) {
+			d.i = 2*i;
+			assert(avldelete(&t, &d.a) == &churn[i].a);
+		}
+		for(i = 0; i < n; i += 3)
+			assert(avlinsert(&t, &churn[i].a) == NULL);
+		verify(t.root, NULL);
+	}
+	printf("Build ok\n");
+}
+
+// Lookups in each direction of keys in and around the even numbers below 2*n.
+void
+lookuptest(void)
+{
+	Avltree t;
+	Int d, *lt, *eq, *gt;
+	int i, n;
+
+	avlinit(&t, Intcmp);
+	n = 100;
+	for(i = 0; i < n; i++) {
+		seta[i].i = 2*i;
+		assert(avlinsert(&t, &seta[i].a) == NULL);
+	}
+	for(d.i = -2; d.i <= 2*n; d.i++) {
+		lt = d.i < 0 ? NULL : &seta[d.i/2 < n ? d.i/2 : n-1];
+		gt = d.i > 2*(n-1) ? NULL : &seta[d.i < 0 ? 0 : (d.i+1)/2];
+		eq = lt != NULL && lt == gt ? lt : NULL;
+		assert((Int*)avllookup(&t, &d.a, -1) == lt);
+		assert((Int*)avllookup(&t, &d.a, 0) == eq);
+		assert((Int*)avllookup(&t, &d.a, 1) == gt);
+	}
+	printf("Lookup ok\n");
+}
+
+// Check that t holds, in order, the nodes in want that are not NULL.
+void
+checkset(Avltree *t, Avl **want)
+{
+	Avl *q;
+	int i;
+
+	verify(t->root, NULL);
+	q = avlmin(t);
+	for(i = 0; i < (int)nelem(seta); i++) {
+		if(want[i] == NULL)
+			continue;
+		assert(q == want[i]);
+		q = avlnext(q);
+	}
+	assert(q == NULL);
+}
+
+// Fill t with the nodes of s in [lo, hi), each with chance p, marking them in in.
+void
+randset(Avltree *t, Int *s, char *in, double p, int lo, int hi)
+{
+	int i;
+
+	avlinit(t, Intcmp);
+	for(i = 0; i < (int)nelem(seta); i++) {
+		s[i].i = i;
+		in[i] = i >= lo && i < hi && drand48() < p;
+		if(in[i])
+			assert(avlinsert(t, &s[i].a) == NULL);
+	}
+}
+
+// Join, split and the set operations against tables of the keys in each tree.
+void
+settest(void)
+{
+	static Avl *want[nelem(seta)], *rest[nelem(seta)], *keep[nelem(seta)];
+	Avltree a, b, r;
+	Int d;
+	Avl *pivot;
+	double pa, pb;
+	int trial, inter, x, i;
+
+	for(trial = 0; trial < 500; trial++) {
+		// Often a small tree against a large one.
+		pa = drand48();
+		pb = trial%3 == 0 ? 0.01 : drand48();
+		x = drand48()*nelem(seta);
+		switch(trial%5) {
+		case 0:
+			randset(&a, seta, ina, pa, 0, x);
+			randset(&b, setb, inb, pb, x+1, nelem(seta));
+			pivot = drand48() < 0.5 ? &seta[x].a : NULL;
+			assert(avljoin(&a, pivot, &b) == &a);
+			assert(b.root == NULL);
+			for(i = 0; i < (int)nelem(seta); i++)
+				want[i] = ina[i] ? &seta[i].a : inb[i] ? &setb[i].a : NULL;
+			want[x] = pivot;
+			checkset(&a, want);
+			break;
+		case 1:
+			randset(&a, seta, ina, pa, 0, nelem(seta));
+			d.i = x;
+			assert(avlsplit(&a, &d.a, &b) == (ina[x] ? &seta[x].a : NULL));
+			for(i = 0; i < (int)nelem(seta); i++) {
+				want[i] = ina[i] && i < x ? &seta[i].a : NULL;
+				rest[i] = ina[i] && i > x ? &seta[i].a : NULL;
+			}
+			checkset(&a, want);
+			checkset(&b, rest);
+			break;
+		case 2:
+			randset(&a, seta, ina, pa, 0, nelem(seta));
+			randset(&b, setb, inb, pb, 0, nelem(seta));
+			assert(avlunion(&a, &b, trial%2 ? &r : NULL) == &a);
+			assert(b.root == NULL);
+			for(i = 0; i < (int)nelem(seta); i++) {
+				want[i] = ina[i] ? &seta[i].a : inb[i] ? &setb[i].a : NULL;
+				rest[i] = ina[i] && inb[i] ? &setb[i].a : NULL;
+			}
+			checkset(&a, want);
+			if(trial%2)
+				checkset(&r, rest);
+			break;
+		case 3:
+		case 4:
+			inter = trial%5 == 3;
+			randset(&a, seta, ina, pa, 0, nelem(seta));
+			randset(&b, setb, inb, pb, 0, nelem(seta));
+			if(inter)
+				assert(avlintersect(&a, &b, trial%2 ? &r : NULL) == &a);
+			else
+				assert(avldifference(&a, &b, trial%2 ? &r : NULL) == &a);
+			for(i = 0; i < (int)nelem(seta); i++) {
+				want[i] = ina[i] && inter == inb[i] ? &seta[i].a : NULL;
+				rest[i] = ina[i] && inter != inb[i] ? &seta[i].a : NULL;
+				keep[i] = inb[i] ? &setb[i].a : NULL;
+			}
+			checkset(&a, want);
+			checkset(&b, keep);
+			if(trial%2)
+				checkset(&r, rest);
+			break;
+		}
+	}
+	printf("Sets ok\n");
+}
+
+// Random inserts and deletes checked against a table of what is in the tree.
+void
+churntest(void)
+{
+	Avltree t;
+	Int *ip, *old, d;
+	int i, j, n;
+
+	avlinit(&t, Intcmp);
+	for(i = 0; i < (int)nelem(churn); i++)
+		churn[i].i = i;
+	for(i = 0; i < 20000; i++) {
+		j = drand48()*nelem(churn);
+		if(drand48() < 0.5) {
+			old = (Int*)avlinsert(&t, &churn[j].a);
+			assert(present[j] ? old == &churn[j] : old == NULL);
+			present[j] = 1;
+		} else {
+			d.i = j;
+			old = (Int*)avldelete(&t, &d.a);
+			assert(present[j] ? old == &churn[j] : old == NULL);
+			present[j] = 0;
+		}
+		if(i%100 == 0)
+			verify(t.root, NULL);
+	}
+	verify(t.root, NULL);
+	n = 0;
+	for(ip = (Int*)avlmin(&t); ip != NULL; ip = (Int*)avlnext(&ip->a)) {
+		assert(present[ip->i]);
+		n++;
+	}
+	for(i = 0; i < (int)nelem(churn); i++)
+		n -= present[i];
+	assert(n == 0);
+	printf("Churn ok\n");
+	ranktest(&t);
 }
 
 void
@@ -118,5 +380,10 @@ main(void)
 	printf("Balance check:\n");
 	checkbalance(&t);
 
+	lookuptest();
+	buildtest();
+	churntest();
+	settest();
+
 	exit(0);
 }
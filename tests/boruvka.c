@@ -0,0 +1,538 @@
+// This solves the same problem as prim.c, https://www.hackerrank.com/challenges/primsmstsub,
+// with a parallel Boruvka algorithm. The implementation is the function boruvka and the
+// worker it starts. Everything else is setup.
+
+// Usage: boruvka [-t nthreads] [-b]
+//
+// Every node starts as a component of its own. In each round the
+// lightest edge leaving every component is found, with ties broken by
+// edge number so the chosen edges form no cycles but pairs, and each
+// component is hooked onto the component at the far end of its edge.
+// Following the hooks to their roots gives the components of the next
+// round, and edges inside a component are dropped. The rounds end when
+// no edges are left, at most log2 of the number of nodes of them. The
+// weight printed is that of the tree spanning the start node's
+// component, as with prim.c.
+//
+// With -b the input is not read. Instead a sparse and a dense random
+// graph are generated and each is solved with the Fibonacci heap loop of
+// prim.c and then with 1, 2, 4... threads up to twice the number of
+// online cpus, and the times are printed.
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_FIBHEAP_IMPLEMENTATION
+#include "../bspfibheap.h"
+#define BSP_GRAPH_IMPLEMENTATION
+#include "../bspgraph.h"
+#define BSP_INTREAD_IMPLEMENTATION
+#include "../bspintread.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+void
+sysfatal(char *fmt, ...)
+{
+	char buf[1024];
+	int w;
+	va_list va;
+
+	w = snprintf(buf, sizeof(buf), "boruvka: ");
+	va_start(va, fmt);
+	w += vsnprintf(buf+w, sizeof(buf)-w, fmt, va);
+	va_end(va);
+	snprintf(buf+w, sizeof(buf)-w, ": %s", strerror(errno));
+
+	fprintf(stderr, "%s\n", buf);
+	exit(1);
+}
+
+Intreader in;
+
+int
+getint(void)
+{
+	int v;
+
+	if(!intread(&in, &v))
+		sysfatal("unexpected end of input");
+	return v;
+}
+
+typedef struct Worker Worker;
+
+struct Worker {
+	pthread_t thr;
+	int id;
+	long len, off;
+};
+
+#define NONE UINT64_MAX
+
+struct {
+	Graphedge *a;
+	int len;
+} edges;
+
+int nnodes;
+
+struct {
+	Worker *w;
+	int nw;
+	int *comp;
+	atomic_int *next;
+	atomic_uint_fast64_t *best;
+	char *intree;
+	int *e, *e2;
+	long elen;
+	pthread_barrier_t bar;
+} bv;
+
+int nthread = 4;
+
+void*
+emalloc(size_t n)
+{
+	void *p;
+
+	p = malloc(n);
+	if(p == NULL)
+		sysfatal("malloc");
+	return p;
+}
+
+int
+serial(void)
+{
+	return pthread_barrier_wait(&bv.bar) == PTHREAD_BARRIER_SERIAL_THREAD;
+}
+
+// This worker's share of n things.
+void
+share(Worker *w, long n, long *lo, long *hi)
+{
+	*lo = n * w->id / bv.nw;
+	*hi = n * (w->id+1) / bv.nw;
+}
+
+void
+lower(atomic_uint_fast64_t *p, uint64_t x)
+{
+	uint64_t old;
+
+	old = atomic_load_explicit(p, memory_order_relaxed);
+	while(x < old) {
+		if(atomic_compare_exchange_weak_explicit(p, &old, x,
+				memory_order_relaxed, memory_order_relaxed))
+			break;
+	}
+}
+
+// Find the lightest edge leaving each component.
+void
+lightest(Worker *w)
+{
+	long i, lo, hi;
+	uint64_t key;
+	int e, cu, cv;
+
+	share(w, bv.elen, &lo, &hi);
+	for(i = lo; i < hi; i++) {
+		e = bv.e[i];
+		cu = bv.comp[edges.a[e].s];
+		cv = bv.comp[edges.a[e].d];
+		if(cu == cv)
+			continue;
+		key = (uint64_t)edges.a[e].w << 32 | (uint32_t)e;
+		lower(&bv.best[cu], key);
+		lower(&bv.best[cv], key);
+	}
+}
+
+// Hook each component onto the one across its lightest edge.
+void
+hook(Worker *w)
+{
+	long c, lo, hi;
+	int e, o;
+
+	share(w, nnodes, &lo, &hi);
+	for(c = lo; c < hi; c++) {
+		if(bv.comp[c] != c)
+			continue;
+		if(atomic_load_explicit(&bv.best[c], memory_order_relaxed) == NONE) {
+			atomic_store_explicit(&bv.next[c], c, memory_order_relaxed);
+			continue;
+		}
+		e = (uint32_t)atomic_load_explicit(&bv.best[c], memory_order_relaxed);
+		o = bv.comp[edges.a[e].s];
+		if(o == c)
+			o = bv.comp[edges.a[e].d];
+		atomic_store_explicit(&bv.next[c], o, memory_order_relaxed);
+	}
+}
+
+/*
+ * Two components that chose the same edge point at each other and
+ * the smaller becomes the root. Every other chosen edge goes in the
+ * tree once.
+ */
+void
+breakpairs(Worker *w)
+{
+	long c, lo, hi;
+	int o;
+
+	share(w, nnodes, &lo, &hi);
+	for(c = lo; c < hi; c++) {
+		if(bv.comp[c] != c)
+			continue;
+		o = atomic_load_explicit(&bv.next[c], memory_order_relaxed);
+		if(o == c)
+			continue;
+		if(c < o && atomic_load_explicit(&bv.next[o], memory_order_relaxed) == c)
+			continue;
+		bv.intree[(uint32_t)atomic_load_explicit(&bv.best[c], memory_order_relaxed)] = 1;
+	}
+	pthread_barrier_wait(&bv.bar);
+	for(c = lo; c < hi; c++) {
+		if(bv.comp[c] != c)
+			continue;
+		o = atomic_load_explicit(&bv.next[c], memory_order_relaxed);
+		if(c < o && atomic_load_explicit(&bv.next[o], memory_order_relaxed) == c)
+			atomic_store_explicit(&bv.next[c], c, memory_order_relaxed);
+		atomic_store_explicit(&bv.best[c], NONE, memory_order_relaxed);
+	}
+}
+
+// Point each component at the root of its tree of hooks.
+void
+jump(Worker *w)
+{
+	long c, lo, hi;
+	int r, n;
+
+	share(w, nnodes, &lo, &hi);
+	for(c = lo; c < hi; c++) {
+		if(bv.comp[c] != c)
+			continue;
+		r = c;
+		while((n = atomic_load_explicit(&bv.next[r], memory_order_relaxed)) != r)
+			r = n;
+		atomic_store_explicit(&bv.next[c], r, memory_order_relaxed);
+	}
+}
+
+void
+relabel(Worker *w)
+{
+	long v, lo, hi;
+
+	share(w, nnodes, &lo, &hi);
+	for(v = lo; v < hi; v++)
+		bv.comp[v] = atomic_load_explicit(&bv.next[bv.comp[v]], memory_order_relaxed);
+}
+
+// Drop the edges inside a component, keeping the order of the rest.
+void
+compact(Worker *w)
+{
+	Worker *wi;
+	long i, lo, hi, off;
+	int e, *t;
+
+	share(w, bv.elen, &lo, &hi);
+	w->len = 0;
+	for(i = lo; i < hi; i++) {
+		e = bv.e[i];
+		if(bv.comp[edges.a[e].s] != bv.comp[edges.a[e].d])
+			w->len++;
+	}
+	if(serial()) {
+		off = 0;
+		for(wi = bv.w; wi < bv.w + bv.nw; wi++) {
+			wi->off = off;
+			off += wi->len;
+		}
+	}
+	pthread_barrier_wait(&bv.bar);
+	off = w->off;
+	for(i = lo; i < hi; i++) {
+		e = bv.e[i];
+		if(bv.comp[edges.a[e].s] != bv.comp[edges.a[e].d])
+			bv.e2[off++] = e;
+	}
+	if(serial()) {
+		t = bv.e;
+		bv.e = bv.e2;
+		bv.e2 = t;
+		bv.elen = bv.w[bv.nw-1].off + bv.w[bv.nw-1].len;
+	}
+	pthread_barrier_wait(&bv.bar);
+}
+
+void*
+worker(void *arg)
+{
+	Worker *w;
+
+	w = arg;
+	while(bv.elen > 0) {
+		lightest(w);
+		pthread_barrier_wait(&bv.bar);
+		hook(w);
+		pthread_barrier_wait(&bv.bar);
+		breakpairs(w);
+		pthread_barrier_wait(&bv.bar);
+		jump(w);
+		pthread_barrier_wait(&bv.bar);
+		relabel(w);
+		pthread_barrier_wait(&bv.bar);
+		compact(w);
+	}
+	return NULL;
+}
+
+long long
+boruvka(int start)
+{
+	Worker *w;
+	long long sum;
+	int i;
+
+	bv.nw = nthread;
+	bv.w = calloc(bv.nw, sizeof(*bv.w));
+	bv.comp = emalloc(nnodes * sizeof(*bv.comp));
+	bv.next = emalloc(nnodes * sizeof(*bv.next));
+	bv.best = emalloc(nnodes * sizeof(*bv.best));
+	bv.intree = calloc(edges.len, 1);
+	bv.e = emalloc(edges.len * sizeof(*bv.e));
+	bv.e2 = emalloc(edges.len * sizeof(*bv.e2));
+	if(bv.w == NULL || bv.intree == NULL)
+		sysfatal("calloc");
+	for(i = 0; i < nnodes; i++) {
+		bv.comp[i] = i;
+		atomic_init(&bv.next[i], i);
+		atomic_init(&bv.best[i], NONE);
+	}
+	for(i = 0; i < edges.len; i++)
+		bv.e[i] = i;
+	bv.elen = edges.len;
+
+	pthread_barrier_init(&bv.bar, NULL, bv.nw);
+	for(w = bv.w; w < bv.w + bv.nw; w++) {
+		w->id = w - bv.w;
+		if(w == bv.w)
+			continue;
+		errno = pthread_create(&w->thr, NULL, worker, w);
+		if(errno != 0)
+			sysfatal("pthread_create");
+	}
+	worker(bv.w);
+	for(w = bv.w+1; w < bv.w + bv.nw; w++)
+		pthread_join(w->thr, NULL);
+	pthread_barrier_destroy(&bv.bar);
+
+	sum = 0;
+	for(i = 0; i < edges.len; i++) {
+		if(bv.intree[i] && bv.comp[edges.a[i].s] == bv.comp[start])
+			sum += edges.a[i].w;
+	}
+
+	free(bv.w);
+	free(bv.comp);
+	free(bv.next);
+	free(bv.best);
+	free(bv.intree);
+	free(bv.e);
+	free(bv.e2);
+	return sum;
+}
+
+Graph graph;
+Fibnode *arcnodes;
+
+int
+arccmp(Fibnode *a, Fibnode *b)
+{
+	Grapharc *e, *f;
+
+	e = graph.arcs + (a - arcnodes);
+	f = graph.arcs + (b - arcnodes);
+
+	if(e->w < f->w)
+		return -1;
+	if(e->w > f->w)
+		return 1;
+	return 0;
+}
+
+// The loop of prim.c, for comparison.
+long long
+prim(int start)
+{
+	Fibheap pq;
+	Grapharc *a;
+	char *intree;
+	long long sum;
+	int i, n;
+
+	if(graphbuild(&graph, nnodes, edges.a, edges.len, GRAPHUNDIRECTED) == NULL)
+		sysfatal("graphbuild");
+	arcnodes = calloc(graph.narcs, sizeof(*arcnodes));
+	intree = calloc(nnodes, 1);
+	if(arcnodes == NULL || intree == NULL)
+		sysfatal("calloc");
+
+	fibinit(&pq, arccmp);
+	sum = 0;
+	n = start;
+	intree[n] = 1;
+	for(;;) {
+		for(i = graph.off[n]; i < graph.off[n+1]; i++) {
+			if(!intree[graph.arcs[i].d])
+				fibinsert(&pq, &arcnodes[i]);
+		}
+		do {
+			if(pq.min == NULL)
+				goto Out;
+			a = graph.arcs + (pq.min - arcnodes);
+			if(fibdeletemin(&pq) < 0)
+				sysfatal("deletion failed");
+		} while(intree[a->d]);
+		n = a->d;
+		intree[n] = 1;
+		sum += a->w;
+	}
+Out:
+	fibfree(&pq);
+	graphfree(&graph);
+	free(arcnodes);
+	free(intree);
+	return sum;
+}
+
+void
+allocedges(int n)
+{
+	edges.len = n;
+	edges.a = emalloc(n * sizeof(*edges.a));
+}
+
+void
+freeedges(void)
+{
+	free(edges.a);
+}
+
+int
+readgraph(void)
+{
+	int i, start;
+
+	if(intreaderinit(&in, 0) == NULL)
+		sysfatal("reading input");
+	nnodes = getint();
+	allocedges(getint());
+	for(i = 0; i < edges.len; i++) {
+		edges.a[i].s = getint() - 1;
+		edges.a[i].d = getint() - 1;
+		edges.a[i].w = getint();
+	}
+	start = getint();
+	return start-1;
+}
+
+// A random graph on n nodes with m edges, weights below 100000.
+void
+gengraph(int n, int m)
+{
+	uint64_t x;
+	int i;
+
+	nnodes = n;
+	allocedges(m);
+	x = 88172645463325252ull;
+	for(i = 0; i < m; i++) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		edges.a[i].s = (x >> 1) % n;
+		edges.a[i].d = (x >> 21) % n;
+		edges.a[i].w = (x >> 41) % 100000;
+	}
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+bench(char *name, int n, int m)
+{
+	long long ref, sum;
+	double t, tp;
+	long ncpu;
+
+	gengraph(n, m);
+	t = now();
+	ref = prim(0);
+	tp = now() - t;
+	printf("%s: %d nodes %d edges\n", name, n, m);
+	printf("fibheap prim %10.3f ms\n", tp*1e3);
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if(ncpu < 1)
+		ncpu = 1;
+	for(nthread = 1; nthread <= 2*ncpu; nthread *= 2) {
+		t = now();
+		sum = boruvka(0);
+		t = now() - t;
+		if(sum != ref)
+			sysfatal("weight %lld, prim found %lld", sum, ref);
+		printf("threads %4d %10.3f ms  speedup %.2f\n", nthread, t*1e3, tp/t);
+	}
+	freeedges();
+}
+
+int
+main(int argc, char **argv)
+{
+	int dobench, start, i;
+
+	dobench = 0;
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-b") == 0)
+			dobench = 1;
+		else if(strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			nthread = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "usage: boruvka [-t nthreads] [-b]\n");
+			exit(1);
+		}
+	}
+	if(nthread < 1)
+		nthread = 1;
+
+	if(dobench) {
+		bench("sparse", 200000, 1000000);
+		bench("dense", 2000, 1000000);
+	} else {
+		start = readgraph();
+		printf("%lld\n", boruvka(start));
+	}
+	exit(0);
+}
@@ -0,0 +1,110 @@
+#define _XOPEN_SOURCE
+
+#define BSP_DARYHEAP_IMPLEMENTATION
+#include "../bspdaryheap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct Int Int;
+struct Int {
+	Darynode d;
+	int i;
+};
+
+int
+intcmp(Darynode *x, Darynode *y)
+{
+	Int *s, *t;
+
+	s = (Int*)x;
+	t = (Int*)y;
+
+	if(s->i < t->i)
+		return -1;
+	if(s->i > t->i)
+		return 1;
+	return 0;
+}
+
+enum {
+	POOLSIZ = 100,
+	RANDSIZ = 500,
+};
+
+// Check heap order and the position map.
+void
+checkheap(Daryheap *h)
+{
+	int i;
+
+	for(i = 0; i < h->len; i++) {
+		assert(h->arr[i]->pos == i);
+		if(i > 0)
+			assert(intcmp(h->arr[(i-1)/BSP_DARYHEAP_D], h->arr[i]) <= 0);
+	}
+}
+
+int
+main(void)
+{
+	Daryheap dh;
+	Darynode *arr[POOLSIZ];
+	Int pool[POOLSIZ], *ip;
+
+	srand48(time(NULL));
+
+	daryinit(&dh, intcmp);
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		printf("Adding %d %p\n", ip->i, (void*)ip);
+		if(daryinsert(&dh, &ip->d) < 0)
+			exit(1);
+	}
+
+	while(dh.min != NULL) {
+		ip = (Int*)dh.min;
+		printf("Heap sorted %d %p\n", ip->i, (void*)ip);
+		darydeletemin(&dh);
+		checkheap(&dh);
+	}
+	daryfree(&dh);
+
+	printf("\nDecrease key test\n");
+
+	daryinitbuf(&dh, intcmp, arr, POOLSIZ);
+	for(ip = pool; ip < pool+10; ip++) {
+		ip->i = ip-pool + 10;
+		daryinsert(&dh, &ip->d);
+	}
+
+	ip = pool+4;
+	ip->i = 4;
+	darydecreasekey(&dh, &ip->d);
+
+	ip = (Int*)dh.min;
+	printf("%d %p\n", ip->i, (void*)ip);
+	darydeletemin(&dh);
+
+	ip = pool+7;
+	ip->i = 7;
+	darydecreasekey(&dh, &ip->d);
+	ip = pool+6;
+	ip->i = 6;
+	darydecreasekey(&dh, &ip->d);
+	checkheap(&dh);
+
+	darydelete(&dh, &pool[8].d);
+	checkheap(&dh);
+
+	while(dh.min != NULL) {
+		ip = (Int*)dh.min;
+		printf("%d %p\n", ip->i, (void*)ip);
+		darydeletemin(&dh);
+	}
+	daryfree(&dh);
+
+	exit(0);
+}
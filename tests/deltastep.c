@@ -0,0 +1,548 @@
+// This solves the same problem as dijkstra.c, https://www.hackerrank.com/challenges/dijkstrashortreach,
+// with the parallel delta-stepping algorithm. The implementation is the function deltastep
+// and the worker it starts. Everything else is setup.
+
+// Usage: deltastep [-t nthreads] [-d delta] [-b]
+//
+// Nodes are kept in buckets of width delta by tentative distance. The
+// smallest bucket is emptied by relaxing the light edges, those shorter
+// than delta, of its nodes until it stays empty, after which the heavy
+// edges of every node settled from it are relaxed once. The nodes of a
+// bucket are shared out among the threads in chunks and distances are
+// lowered with an atomic compare and swap, so a node may be queued more
+// than once; entries whose distance is out of date are skipped.
+//
+// With -b the input is solved with the serial Fibonacci heap loop of
+// dijkstra.c and then with 1, 2, 4... threads up to twice the number of
+// online cpus, and the times are printed instead of the distances.
+//
+// See Meyer and Sanders. 2003. Delta-stepping: a parallelizable shortest
+// path algorithm. J. Algorithms 49, 1, 114-152.
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_FIBHEAP_IMPLEMENTATION
+#include "../bspfibheap.h"
+#define BSP_GRAPH_IMPLEMENTATION
+#include "../bspgraph.h"
+#define BSP_INTREAD_IMPLEMENTATION
+#include "../bspintread.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+void
+sysfatal(char *fmt, ...)
+{
+	char buf[1024];
+	int w;
+	va_list va;
+
+	w = snprintf(buf, sizeof(buf), "deltastep: ");
+	va_start(va, fmt);
+	w += vsnprintf(buf+w, sizeof(buf)-w, fmt, va);
+	va_end(va);
+	snprintf(buf+w, sizeof(buf)-w, ": %s", strerror(errno));
+
+	fprintf(stderr, "%s\n", buf);
+	exit(1);
+}
+
+Intreader in;
+
+int
+getint(void)
+{
+	int v;
+
+	if(!intread(&in, &v))
+		sysfatal("unexpected end of input");
+	return v;
+}
+
+typedef struct Node Node;
+typedef struct Entry Entry;
+typedef struct Vec Vec;
+typedef struct Worker Worker;
+
+// The light arcs of a node come before graph.arcs[mid].
+struct Node {
+	Fibnode heapnode;
+	atomic_int dist;
+	atomic_int stamp;
+	int mid;
+};
+
+struct Entry {
+	int v;
+	int d;
+};
+
+struct Vec {
+	Entry *a;
+	long len, cap;
+};
+
+struct Worker {
+	pthread_t thr;
+	Vec *bkt;
+	Vec settled;
+	long len, off;
+	int min;
+};
+
+enum {
+	CHUNK = 64,
+};
+
+struct {
+	Node *a;
+	int len;
+} nodes;
+
+Graph graph;
+int maxw;
+
+struct {
+	Worker *w;
+	int nw;
+	int nbkt;
+	int delta;
+	int cur;
+	Entry *front;
+	long frontlen, frontcap;
+	atomic_long next;
+	pthread_barrier_t bar;
+} ds;
+
+int nthread = 4;
+int delta;
+
+void
+push(Vec *v, int n, int d)
+{
+	if(v->len == v->cap) {
+		v->cap = 2*v->cap + 64;
+		v->a = realloc(v->a, v->cap * sizeof(*v->a));
+		if(v->a == NULL)
+			sysfatal("realloc");
+	}
+	v->a[v->len].v = n;
+	v->a[v->len].d = d;
+	v->len++;
+}
+
+// Lower the distance of n to d, returning whether it was lowered.
+int
+relax(Node *n, int d)
+{
+	int old;
+
+	old = atomic_load_explicit(&n->dist, memory_order_relaxed);
+	while(d < old) {
+		if(atomic_compare_exchange_weak_explicit(&n->dist, &old, d,
+				memory_order_relaxed, memory_order_relaxed))
+			return 1;
+	}
+	return 0;
+}
+
+int
+serial(void)
+{
+	return pthread_barrier_wait(&ds.bar) == PTHREAD_BARRIER_SERIAL_THREAD;
+}
+
+/*
+ * Move the entries of v in every worker into the shared frontier.
+ * Returns the length of the frontier, the same in every worker.
+ */
+long
+gather(Worker *w, Vec *v)
+{
+	Worker *wi;
+	long off;
+
+	w->len = v->len;
+	if(serial()) {
+		off = 0;
+		for(wi = ds.w; wi < ds.w + ds.nw; wi++) {
+			wi->off = off;
+			off += wi->len;
+		}
+		if(off > ds.frontcap) {
+			ds.frontcap = 2*off;
+			free(ds.front);
+			ds.front = malloc(ds.frontcap * sizeof(*ds.front));
+			if(ds.front == NULL)
+				sysfatal("malloc");
+		}
+		ds.frontlen = off;
+		atomic_store(&ds.next, 0);
+	}
+	pthread_barrier_wait(&ds.bar);
+	if(v->len > 0)
+		memcpy(ds.front + w->off, v->a, v->len * sizeof(*v->a));
+	v->len = 0;
+	pthread_barrier_wait(&ds.bar);
+	return ds.frontlen;
+}
+
+void
+relaxarcs(Worker *w, int d, int lo, int hi)
+{
+	Grapharc *a;
+	int nd;
+
+	for(a = graph.arcs + lo; a < graph.arcs + hi; a++) {
+		nd = d + a->w;
+		if(relax(nodes.a + a->d, nd))
+			push(&w->bkt[nd / ds.delta % ds.nbkt], a->d, nd);
+	}
+}
+
+void
+light(Worker *w)
+{
+	Entry *e, *end;
+	Node *n;
+	long i;
+
+	for(;;) {
+		i = atomic_fetch_add(&ds.next, CHUNK);
+		if(i >= ds.frontlen)
+			break;
+		end = ds.front + (i+CHUNK < ds.frontlen ? i+CHUNK : ds.frontlen);
+		for(e = ds.front + i; e < end; e++) {
+			n = nodes.a + e->v;
+			if(atomic_load_explicit(&n->dist, memory_order_relaxed) != e->d)
+				continue;
+			if(atomic_exchange(&n->stamp, ds.cur+1) != ds.cur+1)
+				push(&w->settled, e->v, 0);
+			relaxarcs(w, e->d, graph.off[e->v], n->mid);
+		}
+	}
+}
+
+void
+heavy(Worker *w)
+{
+	Entry *e, *end;
+	Node *n;
+	long i;
+
+	for(;;) {
+		i = atomic_fetch_add(&ds.next, CHUNK);
+		if(i >= ds.frontlen)
+			break;
+		end = ds.front + (i+CHUNK < ds.frontlen ? i+CHUNK : ds.frontlen);
+		for(e = ds.front + i; e < end; e++) {
+			n = nodes.a + e->v;
+			relaxarcs(w, atomic_load_explicit(&n->dist, memory_order_relaxed),
+				n->mid, graph.off[e->v+1]);
+		}
+	}
+}
+
+// The smallest non-empty bucket at or after the current one.
+int
+nextbucket(Worker *w)
+{
+	int i;
+
+	for(i = ds.cur; i < ds.cur + ds.nbkt; i++) {
+		if(w->bkt[i % ds.nbkt].len > 0)
+			return i;
+	}
+	return INT_MAX;
+}
+
+void*
+worker(void *arg)
+{
+	Worker *w, *wi;
+
+	w = arg;
+	for(;;) {
+		w->min = nextbucket(w);
+		if(serial()) {
+			ds.cur = INT_MAX;
+			for(wi = ds.w; wi < ds.w + ds.nw; wi++) {
+				if(wi->min < ds.cur)
+					ds.cur = wi->min;
+			}
+		}
+		pthread_barrier_wait(&ds.bar);
+		if(ds.cur == INT_MAX)
+			break;
+		while(gather(w, &w->bkt[ds.cur % ds.nbkt]) > 0)
+			light(w);
+		gather(w, &w->settled);
+		heavy(w);
+	}
+	return NULL;
+}
+
+void
+deltastep(int start)
+{
+	Worker *w;
+	Grapharc *a, t;
+	int i;
+
+	ds.nw = nthread;
+	ds.delta = delta;
+	if(ds.delta <= 0) {
+		// The average degree over the heaviest arc, as in Meyer and Sanders.
+		ds.delta = graph.narcs > 0 ? (long)maxw * nodes.len / graph.narcs : 1;
+		if(ds.delta < 1)
+			ds.delta = 1;
+	}
+	ds.nbkt = maxw / ds.delta + 2;
+	ds.cur = 0;
+
+	for(i = 0; i < nodes.len; i++) {
+		atomic_init(&nodes.a[i].dist, INT_MAX);
+		atomic_init(&nodes.a[i].stamp, 0);
+		nodes.a[i].mid = graph.off[i];
+		for(a = graph.arcs + graph.off[i]; a < graph.arcs + graph.off[i+1]; a++) {
+			if(a->w < ds.delta) {
+				t = *a;
+				*a = graph.arcs[nodes.a[i].mid];
+				graph.arcs[nodes.a[i].mid++] = t;
+			}
+		}
+	}
+
+	ds.w = calloc(ds.nw, sizeof(*ds.w));
+	if(ds.w == NULL)
+		sysfatal("calloc");
+	for(w = ds.w; w < ds.w + ds.nw; w++) {
+		w->bkt = calloc(ds.nbkt, sizeof(*w->bkt));
+		if(w->bkt == NULL)
+			sysfatal("calloc");
+	}
+
+	atomic_store(&nodes.a[start].dist, 0);
+	push(&ds.w[0].bkt[0], start, 0);
+
+	pthread_barrier_init(&ds.bar, NULL, ds.nw);
+	for(w = ds.w+1; w < ds.w + ds.nw; w++) {
+		errno = pthread_create(&w->thr, NULL, worker, w);
+		if(errno != 0)
+			sysfatal("pthread_create");
+	}
+	worker(ds.w);
+	for(w = ds.w+1; w < ds.w + ds.nw; w++)
+		pthread_join(w->thr, NULL);
+	pthread_barrier_destroy(&ds.bar);
+
+	for(w = ds.w; w < ds.w + ds.nw; w++) {
+		for(i = 0; i < ds.nbkt; i++)
+			free(w->bkt[i].a);
+		free(w->bkt);
+		free(w->settled.a);
+	}
+	free(ds.w);
+}
+
+int
+nodecmp(Fibnode *a, Fibnode *b)
+{
+	int m, n;
+
+	m = atomic_load_explicit(&((Node*)a)->dist, memory_order_relaxed);
+	n = atomic_load_explicit(&((Node*)b)->dist, memory_order_relaxed);
+
+	if(m < n)
+		return -1;
+	if(m > n)
+		return 1;
+	return 0;
+}
+
+// The loop of dijkstra.c over the same arrays, for comparison.
+void
+dijkstra(int start)
+{
+	Fibheap pq;
+	Node *s, *d;
+	Grapharc *a, *end;
+	int dist, sd;
+
+	for(s = nodes.a; s < nodes.a + nodes.len; s++)
+		atomic_init(&s->dist, -1);
+
+	fibinit(&pq, nodecmp);
+	s = nodes.a + start;
+	atomic_init(&s->dist, 0);
+	fibinsert(&pq, &s->heapnode);
+	while((s = (Node*)pq.min) != NULL) {
+		if(fibdeletemin(&pq) < 0)
+			sysfatal("deletion failed");
+		sd = atomic_load_explicit(&s->dist, memory_order_relaxed);
+		a = graph.arcs + graph.off[s - nodes.a];
+		end = graph.arcs + graph.off[s - nodes.a + 1];
+		for(; a < end; a++) {
+			dist = sd + a->w;
+			d = nodes.a + a->d;
+			if(atomic_load_explicit(&d->dist, memory_order_relaxed) < 0) {
+				atomic_store_explicit(&d->dist, dist, memory_order_relaxed);
+				fibinsert(&pq, &d->heapnode);
+			} else if(atomic_load_explicit(&d->dist, memory_order_relaxed) > dist) {
+				atomic_store_explicit(&d->dist, dist, memory_order_relaxed);
+				fibdecreasekey(&pq, &d->heapnode);
+			}
+		}
+	}
+	fibfree(&pq);
+}
+
+int
+getdist(Node *n)
+{
+	int d;
+
+	d = atomic_load_explicit(&n->dist, memory_order_relaxed);
+	return d == INT_MAX ? -1 : d;
+}
+
+// Read a test case into graph, returning the start node.
+int
+readcase(void)
+{
+	Graphedge *edges, *e;
+	int nnodes, nedges, start;
+
+	nnodes = getint();
+	nedges = getint();
+	edges = malloc(nedges * sizeof(*edges));
+	if(edges == NULL)
+		sysfatal("malloc");
+	maxw = 0;
+	for(e = edges; e < edges + nedges; e++) {
+		e->s = getint() - 1;
+		e->d = getint() - 1;
+		e->w = getint();
+		if(e->w > maxw)
+			maxw = e->w;
+	}
+	start = getint();
+
+	free(nodes.a);
+	nodes.len = nnodes;
+	nodes.a = calloc(nnodes, sizeof(*nodes.a));
+	if(nodes.a == NULL)
+		sysfatal("calloc");
+	graphfree(&graph);
+	if(graphbuild(&graph, nnodes, edges, nedges, GRAPHUNDIRECTED) == NULL)
+		sysfatal("graphbuild");
+	free(edges);
+	return start-1;
+}
+
+void
+printdists(void)
+{
+	Node *n;
+	int i;
+
+	i = 0;
+	for(n = nodes.a; n < nodes.a + nodes.len; n++) {
+		if(getdist(n) == 0)
+			continue;
+		if(i++ > 0)
+			printf(" ");
+		printf("%d", getdist(n));
+	}
+	printf("\n");
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+bench(int start)
+{
+	int *ref;
+	double t, ts;
+	long ncpu;
+	int i;
+
+	ref = malloc(nodes.len * sizeof(*ref));
+	if(ref == NULL)
+		sysfatal("malloc");
+	t = now();
+	dijkstra(start);
+	ts = now() - t;
+	for(i = 0; i < nodes.len; i++)
+		ref[i] = getdist(nodes.a + i);
+	printf("%d nodes %d arcs\n", nodes.len, graph.narcs);
+	printf("fibheap     %10.3f ms\n", ts*1e3);
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if(ncpu < 1)
+		ncpu = 1;
+	for(nthread = 1; nthread <= 2*ncpu; nthread *= 2) {
+		t = now();
+		deltastep(start);
+		t = now() - t;
+		for(i = 0; i < nodes.len; i++) {
+			if(getdist(nodes.a + i) != ref[i])
+				sysfatal("distance mismatch at node %d", i+1);
+		}
+		printf("threads %3d %10.3f ms  delta %d  speedup %.2f\n",
+			nthread, t*1e3, ds.delta, ts/t);
+	}
+	free(ref);
+}
+
+int
+main(int argc, char **argv)
+{
+	int cases, start, dobench, i;
+
+	dobench = 0;
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-b") == 0)
+			dobench = 1;
+		else if(strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			nthread = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-d") == 0 && i+1 < argc)
+			delta = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "usage: deltastep [-t nthreads] [-d delta] [-b]\n");
+			exit(1);
+		}
+	}
+	if(nthread < 1)
+		nthread = 1;
+
+	if(intreaderinit(&in, 0) == NULL)
+		sysfatal("reading input");
+	cases = getint();
+	while(cases-- > 0) {
+		start = readcase();
+		if(dobench) {
+			bench(start);
+		} else {
+			deltastep(start);
+			printdists();
+		}
+	}
+
+	exit(0);
+}
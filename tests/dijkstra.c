@@ -2,14 +2,100 @@
 // The implementation of the Dijkstra algorithm is the function dijkstra. Everything else
 // is setup.
 
+// The priority queue is a Fibonacci heap unless PAIRHEAP, DARYHEAP or
+// RADIXHEAP is defined. INLINEHEAP selects a Fibonacci heap specialized
+// to Node with BSP_FIBHEAP_DEFINE and FIB32HEAP one linked by indices
+// into nodes.a. With BSP_FIBHEAP_STATS the Fibonacci heap's counters
+// are printed to stderr after each search. With -c the time spent in
+// dijkstra and the heap operations it made are printed to stderr at the
+// end for tests/pqbench.c, with the comparisons of nodes if COUNTCMP is
+// defined and - otherwise, so the benchmarked comparison stays bare.
+#define _POSIX_C_SOURCE 200809L
+
+#if defined(PAIRHEAP)
+#define BSP_PAIRHEAP_IMPLEMENTATION
+#include "../bsppairheap.h"
+
+typedef Pairheap Heap;
+typedef Pairnode Heapnode;
+#define heapinit pairinit
+#define heapmin(h) ((h)->min)
+#define heapinsert pairinsert
+#define heapdeletemin(h) (pairdeletemin(h), 0)
+#define heapdecreasekey pairdecreasekey
+#define heapfree(h)
+#elif defined(DARYHEAP)
+#define BSP_DARYHEAP_IMPLEMENTATION
+#include "../bspdaryheap.h"
+
+typedef Daryheap Heap;
+typedef Darynode Heapnode;
+#define heapinit daryinit
+#define heapmin(h) ((h)->min)
+#define heapinsert(h, n) (daryinsert(h, n) < 0 ? sysfatal("insertion failed") : (void)0)
+#define heapdeletemin(h) (darydeletemin(h), 0)
+#define heapdecreasekey darydecreasekey
+#define heapfree daryfree
+#elif defined(INLINEHEAP)
+#include "../bspfibheap.h"
+
+typedef Fibheap Heap;
+typedef Fibnode Heapnode;
+#define heapinit(h, cmp) nodeheapinit(h)
+#define heapmin(h) ((h)->min)
+#define heapinsert(h, n) nodeheapinsert(h, (Node*)(n))
+#define heapdeletemin nodeheapdeletemin
+#define heapdecreasekey(h, n) nodeheapdecreasekey(h, (Node*)(n))
+#define heapfree nodeheapfree
+#elif defined(FIB32HEAP)
+#define BSP_FIBHEAP32_IMPLEMENTATION
+#include "../bspfibheap32.h"
+
+typedef Fib32heap Heap;
+typedef Fib32node Heapnode;
+#define heapinit(h, cmp) fib32init(h, cmp, nodes.a, sizeof(*nodes.a))
+#define heapmin fib32min
+#define heapinsert(h, n) fib32insert(h, (Node*)(n) - nodes.a)
+#define heapdeletemin(h) (fib32deletemin(h), 0)
+#define heapdecreasekey(h, n) fib32decreasekey(h, (Node*)(n) - nodes.a)
+#define heapfree(h)
+#elif defined(RADIXHEAP)
+#define BSP_RADIXHEAP_IMPLEMENTATION
+#include "../bspradixheap.h"
+
+typedef Radixheap Heap;
+typedef Radixnode Heapnode;
+#define heapinit(h, cmp) radixinit(h)
+#define heapmin radixmin
+#define heapinsert(h, n) radixinsert(h, n, ((Node*)(n))->dist)
+#define heapdeletemin(h) (radixdeletemin(h), 0)
+#define heapdecreasekey(h, n) radixdecreasekey(h, n, ((Node*)(n))->dist)
+#define heapfree(h)
+#else
 #define BSP_FIBHEAP_IMPLEMENTATION
 #include "../bspfibheap.h"
 
+typedef Fibheap Heap;
+typedef Fibnode Heapnode;
+#define heapinit fibinit
+#define heapmin(h) ((h)->min)
+#define heapinsert fibinsert
+#define heapdeletemin fibdeletemin
+#define heapdecreasekey fibdecreasekey
+#define heapfree fibfree
+#endif
+
+#define BSP_GRAPH_IMPLEMENTATION
+#include "../bspgraph.h"
+#define BSP_INTREAD_IMPLEMENTATION
+#include "../bspintread.h"
+
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 void
 sysfatal(char *fmt, ...)
@@ -28,40 +114,58 @@ sysfatal(char *fmt, ...)
 	exit(1);
 }
 
-typedef struct Edge Edge;
-typedef struct Node Node;
+Intreader in;
 
-struct Edge {
-	Node *node;
-	Edge *next;
-	int dist;
-};
+int
+getint(void)
+{
+	int v;
+
+	if(!intread(&in, &v))
+		sysfatal("unexpected end of input");
+	return v;
+}
+
+int cflag;
+long long nsolve;
+long nops, ncmp;
+
+long long
+nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000LL + ts.tv_nsec;
+}
+
+typedef struct Node Node;
 
 struct Node {
-	Fibnode fibnode;
-	Edge *edges, **etail;
+	Heapnode heapnode;
 	int dist;
 };
 
+#ifdef INLINEHEAP
+#ifdef COUNTCMP
+#define NODELESS(a, b) (ncmp++, (a)->dist < (b)->dist)
+#else
+#define NODELESS(a, b) ((a)->dist < (b)->dist)
+#endif
+BSP_FIBHEAP_DEFINE(nodeheap, Node, heapnode, NODELESS)
+#endif
+
 struct {
 	Node *a;
 	int len;
 } nodes;
 
-Edge *edgepool;
-
-Edge*
-edgealloc(void)
-{
-	Edge *e;
-
-	if(edgepool == NULL)
-		return malloc(sizeof(Edge));
+struct {
+	Graphedge *a;
+	int len;
+} edges;
 
-	e = edgepool;
-	edgepool = edgepool->next;
-	return e;
-}
+Graph graph;
 
 Node*
 nodedata(int n)
@@ -70,12 +174,15 @@ nodedata(int n)
 }
 
 int
-nodecmp(Fibnode *a, Fibnode *b)
+nodecmp(Heapnode *a, Heapnode *b)
 {
 	Node *m, *n;
 
 	m = (Node*)a;
 	n = (Node*)b;
+#ifdef COUNTCMP
+	ncmp++;
+#endif
 
 	if(m->dist < n->dist)
 		return -1;
@@ -85,93 +192,114 @@ nodecmp(Fibnode *a, Fibnode *b)
 }
 
 void
-addedge(int s, int d, int dist)
+reallocnodes(int nnodes)
 {
-	Edge *e;
-	Node *n;
-
-	e = edgealloc();
-	e->node = nodedata(d);
-	e->dist = dist;
-	e->next = NULL;
-	n = nodedata(s);
-	*n->etail = e;
-	n->etail = &e->next;
+	nodes.len = 2*nnodes;
+	free(nodes.a);
+	nodes.a = calloc(nodes.len, sizeof(*nodes.a));
+	if(nodes.a == NULL)
+		sysfatal("calloc");
 }
 
 void
-initnodedata(Node *n)
+reallocedges(int nedges)
 {
-	*n->etail = edgepool;
-	edgepool = n->edges;
-	n->edges = NULL;
-	n->etail = &n->edges;
-	n->dist = -1;
+	edges.len = 2*nedges;
+	free(edges.a);
+	edges.a = calloc(edges.len, sizeof(*edges.a));
+	if(edges.a == NULL)
+		sysfatal("calloc");
 }
 
+#ifdef BSP_FIBHEAP_STATS
 void
-reallocnodes(int nnodes)
+printstats(Fibstats *st)
 {
-	Node *ni;
+	int i;
 
-	nodes.len = 2*nnodes;
-	free(nodes.a);
-	nodes.a = calloc(nodes.len, sizeof(*nodes.a));
-	for(ni = nodes.a; ni < nodes.a+nodes.len; ni++)
-		ni->etail = &ni->edges;
+	fprintf(stderr, "cmp %lu link %lu cut %lu resize %lu arrpeak %d rankpeak %d\n",
+		st->ncmp, st->nlink, st->ncut, st->nresize, st->arrpeak, st->rankpeak);
+	fprintf(stderr, "consolidate %lu roots %lu rootmax %lu\n",
+		st->nconsolidate, st->rootsum, st->rootmax);
+	fprintf(stderr, "cascade");
+	for(i = 0; i < FIBSTATNHIST; i++)
+		fprintf(stderr, " %lu", st->cascade[i]);
+	fprintf(stderr, "\nroothist");
+	for(i = 0; i < FIBSTATNHIST; i++)
+		fprintf(stderr, " %lu", st->roothist[i]);
+	fprintf(stderr, "\n");
 }
+#endif
 
 void
 dijkstra(int start)
 {
-	Fibheap pq;
+	Heap pq;
 	Node *s, *d;
-	Edge *e;
+	Grapharc *a, *end;
+	long long t;
 	int dist;
 
-	fibinit(&pq, nodecmp);
+	t = nsec();
+	heapinit(&pq, nodecmp);
 	s = nodedata(start);
 	s->dist = 0;
-	fibinsert(&pq, &s->fibnode);
-	while(pq.min != NULL) {
-		s = (Node*)pq.min;
-		if(fibdeletemin(&pq) < 0)
+	heapinsert(&pq, &s->heapnode);
+	nops++;
+	while((s = (Node*)heapmin(&pq)) != NULL) {
+		if(heapdeletemin(&pq) < 0)
 			sysfatal("deletion failed");
-		for(e = s->edges; e != NULL; e = e->next) {
-			dist = s->dist + e->dist;
-			d = e->node;
+		nops++;
+		a = graph.arcs + graph.off[s - nodes.a];
+		end = graph.arcs + graph.off[s - nodes.a + 1];
+		for(; a < end; a++) {
+			dist = s->dist + a->w;
+			d = nodes.a + a->d;
 			if(d->dist < 0) {
 				d->dist = dist;
-				fibinsert(&pq, &d->fibnode);
+				heapinsert(&pq, &d->heapnode);
+				nops++;
 			} else if(d->dist > dist) {
 				d->dist = dist;
-				fibdecreasekey(&pq, &d->fibnode);
+				heapdecreasekey(&pq, &d->heapnode);
+				nops++;
 			}
 		}
 	}
-	fibfree(&pq);
+#ifdef BSP_FIBHEAP_STATS
+	printstats(fibstats(&pq));
+#endif
+	heapfree(&pq);
+	nsolve += nsec() - t;
 }
 
 void
 testcase(void)
 {
+	Graphedge *e;
 	Node *ni;
-	int nnodes, edges, s, d, dist, start, i;
+	int nnodes, nedges, start, i;
 
-	scanf("%d %d", &nnodes, &edges);
+	nnodes = getint();
+	nedges = getint();
 	if(nodes.len < nnodes)
 		reallocnodes(nnodes);
-	for(i = 0; i < nnodes; i++)
-		initnodedata(nodes.a + i);
+	if(edges.len < nedges)
+		reallocedges(nedges);
+	for(ni = nodes.a; ni < nodes.a + nnodes; ni++)
+		ni->dist = -1;
 
-	while(edges-- > 0) {
-		scanf("%d %d %d", &s, &d, &dist);
-		addedge(s, d, dist);
-		addedge(d, s, dist);
+	for(e = edges.a; e < edges.a + nedges; e++) {
+		e->s = getint() - 1;
+		e->d = getint() - 1;
+		e->w = getint();
 	}
 
-	scanf("%d", &start);
+	if(graphbuild(&graph, nnodes, edges.a, nedges, GRAPHUNDIRECTED) == NULL)
+		sysfatal("graphbuild");
+	start = getint();
 	dijkstra(start);
+	graphfree(&graph);
 	i = 0;
 	for(ni = nodes.a; ni < nodes.a + nnodes; ni++) {
 		if(ni->dist == 0)
@@ -184,13 +312,25 @@ testcase(void)
 }
 
 int
-main(void)
+main(int argc, char **argv)
 {
 	int cases;
 
-	scanf("%d", &cases);
+	if(argc > 1 && strcmp(argv[1], "-c") == 0)
+		cflag = 1;
+
+	if(intreaderinit(&in, 0) == NULL)
+		sysfatal("reading input");
+	cases = getint();
 	while(cases-- > 0)
 		testcase();
+	if(cflag) {
+#if defined(COUNTCMP) && !defined(RADIXHEAP)
+		fprintf(stderr, "ns %lld ops %ld cmp %ld\n", nsolve, nops, ncmp);
+#else
+		fprintf(stderr, "ns %lld ops %ld cmp -\n", nsolve, nops);
+#endif
+	}
 
 	exit(0);
 }
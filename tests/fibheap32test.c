@@ -0,0 +1,124 @@
+#define _XOPEN_SOURCE
+
+#define BSP_FIBHEAP32_IMPLEMENTATION
+#include "../bspfibheap32.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct Int Int;
+struct Int {
+	Fib32node f;
+	int i;
+};
+
+int
+intcmp(Fib32node *x, Fib32node *y)
+{
+	Int *s, *t;
+
+	s = (Int*)x;
+	t = (Int*)y;
+
+	if(s->i < t->i)
+		return -1;
+	if(s->i > t->i)
+		return 1;
+	return 0;
+}
+
+enum {
+	POOLSIZ = 100,
+	RANDSIZ = 500,
+};
+
+Int pool[POOLSIZ];
+
+// Check heap order and that the rank is the number of children.
+void
+checktree(Fib32heap *h, uint32_t i)
+{
+	Fib32node *n, *cn;
+	uint32_t c;
+	int nc;
+
+	n = fib32node(h, i);
+	nc = 0;
+	c = n->c;
+	if(c != FIB32NIL) do {
+		cn = fib32node(h, c);
+		assert(cn->p == i);
+		assert(intcmp(n, cn) <= 0);
+		checktree(h, c);
+		nc++;
+		c = cn->next;
+	} while(c != n->c);
+	assert(nc == (int)(n->rankmark >> 1));
+}
+
+void
+checkheap(Fib32heap *h)
+{
+	uint32_t i;
+
+	i = h->min;
+	if(i != FIB32NIL) do {
+		assert(fib32node(h, i)->p == FIB32NIL);
+		assert(intcmp(fib32min(h), fib32node(h, i)) <= 0);
+		checktree(h, i);
+		i = fib32node(h, i)->next;
+	} while(i != h->min);
+}
+
+int
+main(void)
+{
+	Fib32heap fh;
+	Int *ip;
+
+	srand48(time(NULL));
+
+	fib32init(&fh, intcmp, pool, sizeof(*pool));
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		printf("Adding %d %p\n", ip->i, (void*)ip);
+		fib32insert(&fh, ip-pool);
+	}
+
+	while((ip = (Int*)fib32min(&fh)) != NULL) {
+		printf("Heap sorted %d %p\n", ip->i, (void*)ip);
+		fib32deletemin(&fh);
+		checkheap(&fh);
+	}
+
+	printf("\nDecrease key test\n");
+
+	fib32init(&fh, intcmp, pool, sizeof(*pool));
+	for(ip = pool; ip < pool+10; ip++) {
+		ip->i = ip-pool + 10;
+		fib32insert(&fh, ip-pool);
+	}
+
+	pool[4].i = 4;
+	fib32decreasekey(&fh, 4);
+
+	ip = (Int*)fib32min(&fh);
+	printf("%d %p\n", ip->i, (void*)ip);
+	fib32deletemin(&fh);
+
+	pool[7].i = 7;
+	fib32decreasekey(&fh, 7);
+	pool[6].i = 6;
+	fib32decreasekey(&fh, 6);
+	fib32delete(&fh, 8);
+	checkheap(&fh);
+
+	while((ip = (Int*)fib32min(&fh)) != NULL) {
+		printf("%d %p\n", ip->i, (void*)ip);
+		fib32deletemin(&fh);
+	}
+
+	exit(0);
+}
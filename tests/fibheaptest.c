@@ -3,6 +3,7 @@
 #define BSP_FIBHEAP_IMPLEMENTATION
 #include "../bspfibheap.h"
 
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -28,16 +29,56 @@ intcmp(Fibnode *x, Fibnode *y)
 	return 0;
 }
 
+#define INTLESS(a, b) ((a)->i < (b)->i)
+BSP_FIBHEAP_DEFINE(intheap, Int, f, INTLESS)
+
+#define nelem(x) (sizeof(x)/sizeof((x)[0]))
+
 enum {
 	POOLSIZ = 100,
 	RANDSIZ = 500,
 };
 
+// Check heap order and that rank is the number of children.
+void
+checktree(Fibnode *n)
+{
+	Fibnode *c;
+	int nc;
+
+	nc = 0;
+	c = n->c;
+	if(c != NULL) do {
+		assert(c->p == n);
+		assert(intcmp(n, c) <= 0);
+		checktree(c);
+		nc++;
+		c = c->next;
+	} while(c != n->c);
+	assert(nc == n->rank);
+}
+
+void
+checkheap(Fibheap *h)
+{
+	Fibnode *n;
+
+	n = h->min;
+	if(n != NULL) do {
+		assert(n->p == NULL);
+		assert(intcmp(h->min, n) <= 0);
+		checktree(n);
+		n = n->next;
+	} while(n != h->min);
+}
+
 int
 main(void)
 {
-	Fibheap fh;
+	Fibheap fh, fh2;
+	Fibnode *arr[32], *small[2], *batch[POOLSIZ];
 	Int pool[POOLSIZ], *ip;
+	int i, n, step;
 
 	srand48(time(NULL));
 
@@ -53,6 +94,7 @@ main(void)
 		printf("Heap sorted %d %p\n", ip->i, (void*)ip);
 		if(fibdeletemin(&fh) < 0)
 			exit(1);
+		checkheap(&fh);
 	}
 
 	printf("\nDecrease key test\n");
@@ -77,6 +119,7 @@ main(void)
 	ip = pool+6;
 	ip->i = 6;
 	fibdecreasekey(&fh, &ip->f);
+	checkheap(&fh);
 
 	while(fh.min != NULL) {
 		ip = (Int*)fh.min;
@@ -84,5 +127,243 @@ main(void)
 		fibdeletemin(&fh);
 	}
 
+	printf("\nFixed buffer test\n");
+
+	fibinitbuf(&fh, intcmp, arr, fibarrlen(POOLSIZ));
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		fibinsert(&fh, &ip->f);
+	}
+
+	while(fh.min != NULL) {
+		ip = (Int*)fh.min;
+		printf("%d\n", ip->i);
+		if(fibdeletemin(&fh) < 0)
+			exit(1);
+		checkheap(&fh);
+	}
+	fibfree(&fh);
+
+	printf("\nIncremental test\n");
+
+	fibinit(&fh, intcmp);
+	fibsetstep(&fh, 2);
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		fibinsert(&fh, &ip->f);
+	}
+	for(ip = pool; ip < pool+POOLSIZ; ip += 7) {
+		ip->i -= RANDSIZ/10;
+		fibdecreasekey(&fh, &ip->f);
+	}
+	fibdelete(&fh, &pool[3].f);
+
+	while(fh.min != NULL) {
+		ip = (Int*)fh.min;
+		printf("%d\n", ip->i);
+		if(fibdeletemin(&fh) < 0)
+			exit(1);
+		if(fh.min != NULL)
+			assert(intcmp(&ip->f, fh.min) <= 0);
+	}
+	fibfree(&fh);
+
+	// Switching a populated heap to steps, or melding into one, consolidates it.
+	fibinit(&fh, intcmp);
+	fibinit(&fh2, intcmp);
+	for(i = 0; i < POOLSIZ; i++) {
+		pool[i].i = drand48()*RANDSIZ;
+		fibinsert(i%2 ? &fh : &fh2, &pool[i].f);
+	}
+	fibsetstep(&fh, 2);
+	assert(fh.pend == NULL);
+	fibmeld(&fh, &fh2);
+	assert(fh.pend == NULL);
+	n = 0;
+	while(fh.min != NULL) {
+		ip = (Int*)fh.min;
+		assert(fibdeletemin(&fh) == 0);
+		if(fh.min != NULL)
+			assert(intcmp(&ip->f, fh.min) <= 0);
+		n++;
+	}
+	assert(n == POOLSIZ);
+	fibfree(&fh);
+	fibfree(&fh2);
+
+	printf("\nIncremental fixed buffer test\n");
+
+	// The buffer is too short, so consolidation must keep deferring without losing nodes.
+	fibinitbuf(&fh, intcmp, small, nelem(small));
+	fibsetstep(&fh, 1);
+	for(i = 0; i < 64; i++) {
+		pool[i].i = i%2 ? i : drand48()*RANDSIZ;
+		fibinsert(&fh, &pool[i].f);
+	}
+	n = 0;
+	while(fh.min != NULL) {
+		ip = (Int*)fh.min;
+		assert(fibdeletemin(&fh) == 0);
+		if(fh.min != NULL)
+			assert(intcmp(&ip->f, fh.min) <= 0);
+		n++;
+	}
+	assert(n == 64);
+
+	// Raising the minimum must not need the buffer either.
+	fibinitbuf(&fh, intcmp, small, nelem(small));
+	for(i = 0; i < 64; i++) {
+		pool[i].i = drand48()*RANDSIZ;
+		fibinsert(&fh, &pool[i].f);
+	}
+	for(i = 0; i < 200; i++) {
+		ip = (Int*)fh.min;
+		ip->i += RANDSIZ/2;
+		fibupdatekey(&fh, &ip->f);
+		for(n = 0; n < 64; n++)
+			assert(intcmp(fh.min, &pool[n].f) <= 0);
+	}
+	printf("ok\n");
+
+	printf("\nBatch test\n");
+
+	fibinit(&fh, intcmp);
+	for(i = 0; i < POOLSIZ; i++) {
+		pool[i].i = drand48()*RANDSIZ;
+		batch[i] = &pool[i].f;
+	}
+	fibinsertmany(&fh, batch, POOLSIZ);
+	checkheap(&fh);
+
+	while((n = fibpopmany(&fh, batch, 30)) > 0) {
+		for(i = 0; i < n; i++) {
+			ip = (Int*)batch[i];
+			printf("%d\n", ip->i);
+			if(i > 0)
+				assert(intcmp(batch[i-1], batch[i]) <= 0);
+		}
+		checkheap(&fh);
+	}
+	fibfree(&fh);
+
+	// A buffer too short to consolidate makes each batch stop early, but nothing is lost.
+	fibinitbuf(&fh, intcmp, small, nelem(small));
+	for(i = 0; i < 64; i++) {
+		pool[i].i = drand48()*RANDSIZ;
+		batch[i] = &pool[i].f;
+	}
+	fibinsertmany(&fh, batch, 64);
+	i = 0;
+	while((n = fibpopmany(&fh, batch+i, 64-i)) > 0) {
+		checkheap(&fh);
+		i += n;
+	}
+	assert(i == 64);
+	for(i = 1; i < 64; i++)
+		assert(intcmp(batch[i-1], batch[i]) <= 0);
+
+	printf("\nUpdate key test\n");
+
+	for(step = 0; step <= 2; step += 2) {
+		fibinit(&fh, intcmp);
+		fibsetstep(&fh, step);
+		for(ip = pool; ip < pool+POOLSIZ; ip++) {
+			ip->i = drand48()*RANDSIZ;
+			fibinsert(&fh, &ip->f);
+		}
+		// Build trees before moving keys both ways.
+		ip = (Int*)fh.min;
+		fibdeletemin(&fh);
+		ip->i = -1;
+		for(i = 0; i < 5*POOLSIZ; i++) {
+			ip = pool + (int)(drand48()*POOLSIZ);
+			if(ip->i < 0)
+				continue;
+			ip->i = drand48()*RANDSIZ;
+			fibupdatekey(&fh, &ip->f);
+			// Raise the minimum too, which needs a new one found.
+			if(i%10 == 0) {
+				ip = (Int*)fh.min;
+				ip->i += RANDSIZ/2;
+				fibupdatekey(&fh, &ip->f);
+			}
+			if(step == 0)
+				checkheap(&fh);
+		}
+		n = 0;
+		while(fh.min != NULL) {
+			ip = (Int*)fh.min;
+			if(fibdeletemin(&fh) < 0)
+				exit(1);
+			if(fh.min != NULL)
+				assert(intcmp(&ip->f, fh.min) <= 0);
+			n++;
+		}
+		assert(n == POOLSIZ-1);
+		fibfree(&fh);
+	}
+
+	intheapinit(&fh);
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		intheapinsert(&fh, ip);
+	}
+	ip = intheapmin(&fh);
+	intheapdeletemin(&fh);
+	ip->i = -1;
+	for(i = 0; i < 5*POOLSIZ; i++) {
+		ip = pool + (int)(drand48()*POOLSIZ);
+		if(ip->i < 0)
+			continue;
+		ip->i = drand48()*RANDSIZ;
+		intheapupdatekey(&fh, ip);
+		if(i%10 == 0) {
+			ip = intheapmin(&fh);
+			ip->i += RANDSIZ/2;
+			intheapupdatekey(&fh, ip);
+		}
+		checkheap(&fh);
+	}
+	intheapfree(&fh);
+
+	// Failed consolidations only leave the heap unconsolidated.
+	intheapinitbuf(&fh, small, nelem(small));
+	for(ip = pool; ip < pool+64; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		intheapinsert(&fh, ip);
+	}
+	n = 0;
+	while((ip = intheapmin(&fh)) != NULL) {
+		intheapdeletemin(&fh);
+		checkheap(&fh);
+		if(fh.min != NULL)
+			assert(intcmp(&ip->f, fh.min) <= 0);
+		n++;
+	}
+	assert(n == 64);
+	printf("ok\n");
+
+	printf("\nSpecialized heap test\n");
+
+	intheapinit(&fh);
+	for(ip = pool; ip < pool+10; ip++) {
+		ip->i = ip-pool + 10;
+		intheapinsert(&fh, ip);
+	}
+
+	ip = pool+4;
+	ip->i = 4;
+	intheapdecreasekey(&fh, ip);
+	intheapdelete(&fh, pool+8);
+	checkheap(&fh);
+
+	while((ip = intheapmin(&fh)) != NULL) {
+		printf("%d %p\n", ip->i, (void*)ip);
+		if(intheapdeletemin(&fh) < 0)
+			exit(1);
+		checkheap(&fh);
+	}
+	intheapfree(&fh);
+
 	exit(0);
 }
@@ -0,0 +1,155 @@
+/*
+ * Generate graphs in the input format of dijkstra.c, or of prim.c
+ * with -p, on standard output.
+ *
+ *	graphgen [-p] [-t random|grid|power] [-n nodes] [-m edges]
+ *		[-w min,max] [-s seed]
+ *
+ * A random graph has m edges between nodes chosen uniformly. A grid
+ * graph is the largest square grid of at most n nodes with an edge
+ * between each pair of neighbours, and ignores m. A power graph grows
+ * by preferential attachment: each node after the first joins m/n
+ * edges to earlier nodes picked in proportion to their degree, which
+ * gives a few hubs of very high degree. Weights are uniform between
+ * min and max, and the search starts from node 1.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint64_t rngstate = 88172645463325252ull;
+
+uint64_t
+rnd(void)
+{
+	rngstate ^= rngstate << 13;
+	rngstate ^= rngstate >> 7;
+	rngstate ^= rngstate << 17;
+	return rngstate;
+}
+
+int wmin = 1, wmax = 100000;
+
+void
+edge(int s, int d)
+{
+	printf("%d %d %d\n", s+1, d+1, wmin + (int)(rnd() % ((uint64_t)wmax-wmin+1)));
+}
+
+void
+randgraph(int n, int m)
+{
+	int i;
+
+	printf("%d %d\n", n, m);
+	for(i = 0; i < m; i++)
+		edge(rnd() % n, rnd() % n);
+}
+
+void
+gridgraph(int n)
+{
+	int side, x, y;
+
+	for(side = 1; (side+1)*(side+1) <= n; side++)
+		;
+	printf("%d %d\n", side*side, 2*side*(side-1));
+	for(y = 0; y < side; y++) {
+		for(x = 0; x < side; x++) {
+			if(x+1 < side)
+				edge(y*side + x, y*side + x+1);
+			if(y+1 < side)
+				edge(y*side + x, (y+1)*side + x);
+		}
+	}
+}
+
+void
+powergraph(int n, int m)
+{
+	int *end, nend, base, k, v, i;
+
+	k = m/n > 0 ? m/n : 1;
+	// Each edge adds both its ends, so a pick from end is by degree.
+	end = malloc(2 * (size_t)k * n * sizeof(*end));
+	if(end == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	printf("%d %d\n", n, k*(n-1));
+	nend = 0;
+	for(v = 1; v < n; v++) {
+		// Only the ends of earlier nodes, so v gets no loops.
+		base = nend;
+		for(i = 0; i < k; i++) {
+			end[nend] = base == 0 ? 0 : end[rnd() % base];
+			end[nend+1] = v;
+			edge(v, end[nend]);
+			nend += 2;
+		}
+	}
+	free(end);
+}
+
+void
+usage(void)
+{
+	fprintf(stderr, "usage: graphgen [-p] [-t random|grid|power] [-n nodes] [-m edges] [-w min,max] [-s seed]\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	char *type;
+	int pflag, n, m, i;
+
+	pflag = 0;
+	type = "random";
+	n = 100000;
+	m = 1000000;
+	for(i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "-p") == 0) {
+			pflag = 1;
+			continue;
+		}
+		if(argv[i][0] != '-' || i+1 == argc)
+			usage();
+		switch(argv[i++][1]) {
+		case 't':
+			type = argv[i];
+			break;
+		case 'n':
+			n = atoi(argv[i]);
+			break;
+		case 'm':
+			m = atoi(argv[i]);
+			break;
+		case 'w':
+			if(sscanf(argv[i], "%d,%d", &wmin, &wmax) != 2)
+				usage();
+			break;
+		case 's':
+			rngstate = strtoull(argv[i], NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	if(n < 2 || m < 1 || wmin < 0 || wmax < wmin || rngstate == 0)
+		usage();
+
+	if(!pflag)
+		printf("1\n");
+	if(strcmp(type, "random") == 0)
+		randgraph(n, m);
+	else if(strcmp(type, "grid") == 0)
+		gridgraph(n);
+	else if(strcmp(type, "power") == 0)
+		powergraph(n, m);
+	else
+		usage();
+	printf("1\n");
+	return 0;
+}
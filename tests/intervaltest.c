@@ -0,0 +1,330 @@
+/*
+ * Interval tree on bspavl.h, as an example and test of its augmentation.
+ *
+ * The intervals are kept in order of their low end, and each node keeps
+ * the highest high end and the sum of the weights in its subtree. A
+ * search for the intervals overlapping [x, y] skips any subtree whose
+ * highest end is below x and stops going right at the first low end
+ * past y, so it visits O(log n + k) nodes to report k intervals.
+ *
+ * Without arguments it inserts and deletes random intervals and checks
+ * the aggregates, the overlap searches and avlrange sums against scans
+ * of all the intervals, printing how many intervals a search found and
+ * how many nodes it visited on average. With -b it times searches
+ * against a walk of the whole tree with avlnext.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_AVL_IMPLEMENTATION
+#include "../bspavl.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+	NIV = 5000,
+	SPAN = 100000,
+	MAXLEN = 1000,
+	NOPS = 50000,
+	NQUERY = 20000,
+};
+
+typedef struct Iv Iv;
+struct Iv {
+	Avl a;
+	int lo, hi;
+	int id;
+	long w;
+	int max;
+	long sum;
+};
+
+Iv ivs[NIV];
+char present[NIV];
+long nvisit, nfound;
+
+uint64_t rngstate = 88172645463325252ull;
+
+int
+rnd(int n)
+{
+	rngstate ^= rngstate << 13;
+	rngstate ^= rngstate >> 7;
+	rngstate ^= rngstate << 17;
+	return rngstate % n;
+}
+
+// By low end, then by id so intervals with the same start can coexist.
+int
+ivcmp(Avl *a, Avl *b)
+{
+	Iv *x, *y;
+
+	x = (Iv*)a;
+	y = (Iv*)b;
+	if(x->lo != y->lo)
+		return x->lo < y->lo ? -1 : 1;
+	if(x->id != y->id)
+		return x->id < y->id ? -1 : 1;
+	return 0;
+}
+
+void
+ivaug(Avl *a)
+{
+	Iv *v, *c;
+	int i;
+
+	v = (Iv*)a;
+	v->max = v->hi;
+	v->sum = v->w;
+	for(i = 0; i < 2; i++) {
+		if((c = (Iv*)a->c[i]) == NULL)
+			continue;
+		if(c->max > v->max)
+			v->max = c->max;
+		v->sum += c->sum;
+	}
+}
+
+// Call f on every interval under a overlapping [x, y].
+void
+overlap(Avl *a, int x, int y, void (*f)(Iv*, void*), void *aux)
+{
+	Iv *v;
+
+	for(; a != NULL; a = a->c[1]) {
+		nvisit++;
+		v = (Iv*)a;
+		if(v->max < x)
+			return;
+		overlap(a->c[0], x, y, f, aux);
+		if(v->lo > y)
+			return;
+		if(v->hi >= x)
+			f(v, aux);
+	}
+}
+
+void
+mark(Iv *v, void *aux)
+{
+	char *seen;
+
+	seen = aux;
+	assert(!seen[v->id]);
+	seen[v->id] = 1;
+	nfound++;
+}
+
+void
+addw(Avl *a, int whole, void *aux)
+{
+	*(long*)aux += whole ? ((Iv*)a)->sum : ((Iv*)a)->w;
+}
+
+// Check order, parents and the aggregates, returning the height.
+int
+verify(Avl *a, Avl *p)
+{
+	Iv *v;
+	int dl, dr, max;
+	long sum;
+
+	if(a == NULL)
+		return 0;
+	v = (Iv*)a;
+	assert(a->p == p);
+	assert(a->c[0] == NULL || ivcmp(a->c[0], a) < 0);
+	assert(a->c[1] == NULL || ivcmp(a->c[1], a) > 0);
+	dl = verify(a->c[0], a);
+	dr = verify(a->c[1], a);
+	assert(dr - dl == a->b);
+	max = v->hi;
+	sum = v->w;
+	if(a->c[0] != NULL) {
+		max = ((Iv*)a->c[0])->max > max ? ((Iv*)a->c[0])->max : max;
+		sum += ((Iv*)a->c[0])->sum;
+	}
+	if(a->c[1] != NULL) {
+		max = ((Iv*)a->c[1])->max > max ? ((Iv*)a->c[1])->max : max;
+		sum += ((Iv*)a->c[1])->sum;
+	}
+	assert(v->max == max && v->sum == sum);
+	return (dl > dr ? dl : dr) + 1;
+}
+
+void
+randiv(Iv *v)
+{
+	v->lo = rnd(SPAN);
+	v->hi = v->lo + rnd(MAXLEN);
+	v->w = rnd(1000);
+}
+
+void
+query(Avltree *t)
+{
+	static char seen[NIV];
+	Iv lo, hi;
+	long want, got;
+	int x, y, i;
+
+	x = rnd(SPAN + MAXLEN);
+	y = x + rnd(2*MAXLEN);
+	memset(seen, 0, sizeof(seen));
+	overlap(t->root, x, y, mark, seen);
+	for(i = 0; i < NIV; i++)
+		assert(seen[i] == (present[i] && ivs[i].lo <= y && ivs[i].hi >= x));
+
+	// The weights of the intervals starting in [x, y).
+	lo.lo = x;
+	lo.id = -1;
+	hi.lo = y;
+	hi.id = -1;
+	want = 0;
+	for(i = 0; i < NIV; i++) {
+		if(present[i] && ivs[i].lo >= x && ivs[i].lo < y)
+			want += ivs[i].w;
+	}
+	got = 0;
+	avlrange(t, &lo.a, &hi.a, addw, &got);
+	assert(got == want);
+}
+
+void
+randomtest(void)
+{
+	Avltree t;
+	Iv *v, *old;
+	int op, n, i;
+
+	avlinit(&t, ivcmp);
+	t.aug = ivaug;
+	for(i = 0; i < NIV; i++)
+		ivs[i].id = i;
+	for(op = 0; op < NOPS; op++) {
+		i = rnd(NIV);
+		v = ivs + i;
+		switch(rnd(3)) {
+		case 0:
+			if(present[i])
+				assert(avldelete(&t, &v->a) == &v->a);
+			randiv(v);
+			assert(avlinsert(&t, &v->a) == NULL);
+			present[i] = 1;
+			break;
+		case 1:
+			// Replace a present interval by a copy with a new weight and back.
+			if(!present[i])
+				break;
+			old = v;
+			v = malloc(sizeof(*v));
+			assert(v != NULL);
+			*v = *old;
+			v->w = rnd(1000);
+			assert(avlinsert(&t, &v->a) == &old->a);
+			assert(avldelete(&t, &v->a) == &v->a);
+			free(v);
+			assert(avlinsert(&t, &old->a) == NULL);
+			break;
+		case 2:
+			old = (Iv*)avldelete(&t, &v->a);
+			assert(old == (present[i] ? v : NULL));
+			present[i] = 0;
+			break;
+		}
+		if(op%500 == 0) {
+			verify(t.root, NULL);
+			query(&t);
+		}
+	}
+	verify(t.root, NULL);
+
+	n = 0;
+	for(i = 0; i < NIV; i++)
+		n += present[i];
+	nvisit = nfound = 0;
+	for(i = 0; i < 1000; i++)
+		query(&t);
+	printf("%d intervals: %.1f found and %.1f nodes visited per search\n",
+		n, nfound/1000.0, nvisit/1000.0);
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+count(Iv *v, void *aux)
+{
+	(void)v;
+	(*(long*)aux)++;
+}
+
+void
+bench(void)
+{
+	Avltree t;
+	Avl *a;
+	Iv *v;
+	long n, m;
+	double start;
+	int x, y, i;
+
+	avlinit(&t, ivcmp);
+	t.aug = ivaug;
+	for(i = 0; i < NIV; i++) {
+		ivs[i].id = i;
+		randiv(ivs + i);
+		avlinsert(&t, &ivs[i].a);
+	}
+
+	rngstate = 88172645463325252ull;
+	n = 0;
+	start = now();
+	for(i = 0; i < NQUERY; i++) {
+		x = rnd(SPAN);
+		y = x + rnd(MAXLEN);
+		overlap(t.root, x, y, count, &n);
+	}
+	printf("interval tree %8.1f ns/query, found %ld\n",
+		(now() - start)*1e9/NQUERY, n);
+
+	rngstate = 88172645463325252ull;
+	m = 0;
+	start = now();
+	for(i = 0; i < NQUERY; i++) {
+		x = rnd(SPAN);
+		y = x + rnd(MAXLEN);
+		for(a = avlmin(&t); a != NULL; a = avlnext(a)) {
+			v = (Iv*)a;
+			if(v->lo > y)
+				break;
+			m += v->hi >= x;
+		}
+	}
+	printf("avlnext walk  %8.1f ns/query, found %ld\n",
+		(now() - start)*1e9/NQUERY, m);
+	assert(n == m);
+}
+
+int
+main(int argc, char **argv)
+{
+	if(argc > 1 && strcmp(argv[1], "-b") == 0) {
+		bench();
+		return 0;
+	}
+	randomtest();
+	return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * Test and benchmark for bspintread.h.
+ *
+ * Without arguments it checks hand picked inputs, random ones cut
+ * short at every offset near their end, and reading through both a
+ * regular file and a pipe.
+ *
+ * With -b it generates graph-like input of random triples, or reads
+ * the file named after -b, and prints the MB/s of intread against
+ * strtol and fscanf over the same bytes.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_INTREAD_IMPLEMENTATION
+#include "../bspintread.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define nelem(x) (sizeof(x)/sizeof((x)[0]))
+
+enum {
+	NRAND = 100000,
+	NBENCH = 6000000,
+};
+
+uint64_t rngstate = 88172645463325252ull;
+
+uint64_t
+rnd(void)
+{
+	rngstate ^= rngstate << 13;
+	rngstate ^= rngstate >> 7;
+	rngstate ^= rngstate << 17;
+	return rngstate;
+}
+
+// A random int with a random number of digits.
+int
+rndint(void)
+{
+	static const long long lim[] = {
+		10, 100, 1000, 10000, 100000, 1000000, 10000000,
+		100000000, 1000000000, 2147483647,
+	};
+	long long v;
+
+	v = rnd() % lim[rnd() % nelem(lim)];
+	return rnd() % 4 == 0 ? -v : v;
+}
+
+int
+isdig(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// The integers in buf the slow way.
+int
+refparse(char *buf, size_t len, int *out)
+{
+	char tmp[16], *p, *e;
+	int n, i;
+
+	n = 0;
+	p = buf;
+	e = buf + len;
+	while(p < e) {
+		if(!isdig(*p) && !(*p == '-' && p+1 < e && isdig(p[1]))) {
+			p++;
+			continue;
+		}
+		i = 0;
+		tmp[i++] = *p++;
+		while(p < e && isdig(*p) && i < 15)
+			tmp[i++] = *p++;
+		tmp[i] = '\0';
+		out[n++] = strtol(tmp, NULL, 10);
+	}
+	return n;
+}
+
+void
+checkreader(Intreader *r, int *want, int nwant)
+{
+	int i, v;
+
+	for(i = 0; i < nwant; i++) {
+		assert(intread(r, &v) == 1);
+		assert(v == want[i]);
+	}
+	assert(intread(r, &v) == 0);
+	assert(intread(r, &v) == 0);
+}
+
+void
+checkbuf(char *buf, size_t len, int *want, int nwant)
+{
+	Intreader r;
+
+	intreaderbuf(&r, buf, len);
+	checkreader(&r, want, nwant);
+}
+
+void
+fixedtest(void)
+{
+	static char in[] = "0 -5 12345678 123456789\n2147483647 -2147483647\t007 "
+		"x12y-3 - -x 99999999 1234567 00000000012 1";
+	static int want[] = {
+		0, -5, 12345678, 123456789, 2147483647, -2147483647, 7,
+		12, -3, 99999999, 1234567, 12, 1,
+	};
+	char buf[16];
+	int i, v;
+
+	checkbuf(in, strlen(in), want, nelem(want));
+	checkbuf("", 0, NULL, 0);
+	checkbuf("  \n- ", 5, NULL, 0);
+
+	// Each length of number with nothing after it.
+	for(i = 1; i <= 10; i++) {
+		memset(buf, '7', i);
+		buf[0] = '1';
+		buf[i] = '\0';
+		v = strtol(buf, NULL, 10);
+		checkbuf(buf, i, &v, 1);
+	}
+	printf("Fixed inputs ok\n");
+}
+
+void
+randomtest(void)
+{
+	char *buf, *p;
+	int *want, n, i;
+	size_t len;
+
+	want = malloc(NRAND * sizeof(*want));
+	buf = malloc(NRAND * 16);
+	assert(want != NULL && buf != NULL);
+	p = buf;
+	for(i = 0; i < NRAND; i++) {
+		p += sprintf(p, "%d", rndint());
+		*p++ = " \n\t,x"[rnd() % 5];
+	}
+	len = p - buf;
+
+	// Cut the buffer short so the scanner runs into its end everywhere.
+	for(i = 0; i < 40; i++) {
+		n = refparse(buf, len-i, want);
+		checkbuf(buf, len-i, want, n);
+	}
+	printf("Random inputs ok\n");
+	free(want);
+	free(buf);
+}
+
+void
+fdtest(void)
+{
+	static char in[] = "3 1 4 1 5\n9 2 6 5 3 5 -8 9 7 9 3 2 3 8 4 6\n";
+	int want[64], n, fd[2];
+	Intreader r;
+	FILE *f;
+
+	n = refparse(in, strlen(in), want);
+
+	f = tmpfile();
+	assert(f != NULL);
+	fputs(in, f);
+	fflush(f);
+	assert(intreaderinit(&r, fileno(f)) != NULL);
+	assert(r.mapped);
+	checkreader(&r, want, n);
+	intreaderfree(&r);
+	fclose(f);
+
+	assert(pipe(fd) == 0);
+	assert(write(fd[1], in, strlen(in)) == (ssize_t)strlen(in));
+	close(fd[1]);
+	assert(intreaderinit(&r, fd[0]) != NULL);
+	assert(!r.mapped);
+	checkreader(&r, want, n);
+	intreaderfree(&r);
+	close(fd[0]);
+	printf("File and pipe ok\n");
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+report(char *name, size_t len, double t, long long sum)
+{
+	printf("%-8s %8.1f MB/s  %8.3f s  sum %lld\n", name, len/t/1e6, t, sum);
+}
+
+void
+bench(char *file)
+{
+	Intreader r;
+	FILE *f;
+	char *buf, *p, *q;
+	long long sum;
+	size_t len;
+	double t;
+	int i, v;
+
+	f = file != NULL ? fopen(file, "r") : tmpfile();
+	if(f == NULL) {
+		perror(file);
+		exit(1);
+	}
+	if(file == NULL) {
+		// Dijkstra's input: two node numbers and a weight to a line.
+		for(i = 0; i < NBENCH; i++)
+			fprintf(f, "%d %d %d\n", (int)(rnd() % 1000000) + 1,
+				(int)(rnd() % 1000000) + 1, (int)(rnd() % 100000));
+		fflush(f);
+	}
+	if(intreaderinit(&r, fileno(f)) == NULL) {
+		perror("intreaderinit");
+		exit(1);
+	}
+	len = r.len;
+	printf("%zu bytes\n", len);
+
+	// Copy the bytes out so every reader starts from the same memory.
+	buf = malloc(len+1);
+	assert(buf != NULL);
+	memcpy(buf, r.buf, len);
+	buf[len] = '\0';
+	intreaderfree(&r);
+
+	intreaderbuf(&r, buf, len);
+	sum = 0;
+	t = now();
+	while(intread(&r, &v))
+		sum += v;
+	report("intread", len, now() - t, sum);
+
+	sum = 0;
+	t = now();
+	for(p = buf;; p = q) {
+		v = strtol(p, &q, 10);
+		if(q == p)
+			break;
+		sum += v;
+	}
+	report("strtol", len, now() - t, sum);
+
+	rewind(f);
+	sum = 0;
+	t = now();
+	while(fscanf(f, "%d", &v) == 1)
+		sum += v;
+	report("fscanf", len, now() - t, sum);
+
+	free(buf);
+	fclose(f);
+}
+
+int
+main(int argc, char **argv)
+{
+	if(argc > 1 && strcmp(argv[1], "-b") == 0) {
+		bench(argc > 2 ? argv[2] : NULL);
+		return 0;
+	}
+	fixedtest();
+	randomtest();
+	fdtest();
+	return 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * Stress test and throughput benchmark for bspmultiqueue.h.
+ *
+ * Without arguments a number of threads insert and remove nodes
+ * concurrently and the test checks that every node inserted comes
+ * out exactly once and that the sub-heaps are left in heap order.
+ *
+ * With -b it runs the hold model, each thread removing a node and
+ * inserting it again with a larger key, for increasing numbers of
+ * threads and prints the throughput of each.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_MULTIQUEUE_IMPLEMENTATION
+#include "../bspmultiqueue.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct Item Item;
+struct Item {
+	Mqnode m;
+	_Atomic uint64_t key;
+	atomic_int out;
+};
+
+enum {
+	NTHREAD = 8,
+	NITEM = 200000,
+	NPREFILL = 1000000,
+	NHOLD = 2000000,
+};
+
+Multiqueue mq;
+Item *items;
+int nthread, nitem;
+atomic_long live;
+pthread_barrier_t start;
+
+int
+itemcmp(Mqnode *x, Mqnode *y)
+{
+	uint64_t s, t;
+
+	s = atomic_load_explicit(&((Item*)x)->key, memory_order_relaxed);
+	t = atomic_load_explicit(&((Item*)y)->key, memory_order_relaxed);
+	if(s < t)
+		return -1;
+	if(s > t)
+		return 1;
+	return 0;
+}
+
+uint64_t
+rnd(uint64_t *x)
+{
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+	return *x;
+}
+
+void
+take(Mqnode *n)
+{
+	Item *ip;
+	int out;
+
+	ip = (Item*)n;
+	assert(ip >= items && ip < items+nitem);
+	out = atomic_fetch_add(&ip->out, 1);
+	assert(out == 0);
+	atomic_fetch_sub(&live, 1);
+}
+
+void*
+stress(void *arg)
+{
+	Mqnode *n;
+	uint64_t x;
+	int id, i, lo, hi;
+
+	id = (int)(intptr_t)arg;
+	x = id*7919 + 1;
+	lo = nitem / nthread * id;
+	hi = id == nthread-1 ? nitem : lo + nitem/nthread;
+
+	pthread_barrier_wait(&start);
+	for(i = lo; i < hi; i++) {
+		atomic_store(&items[i].key, rnd(&x) % 1000);
+		atomic_fetch_add(&live, 1);
+		mqinsert(&mq, &items[i].m);
+		if(rnd(&x) % 3 == 0 && (n = mqdeletemin(&mq)) != NULL)
+			take(n);
+	}
+	while(atomic_load(&live) > 0) {
+		if((n = mqdeletemin(&mq)) != NULL)
+			take(n);
+	}
+	return NULL;
+}
+
+void
+checktree(Mqnode *n)
+{
+	Mqnode *c;
+
+	for(c = n->c; c != NULL; c = c->next) {
+		assert(itemcmp(n, c) <= 0);
+		checktree(c);
+	}
+}
+
+void
+stresstest(void)
+{
+	pthread_t thr[NTHREAD];
+	int i;
+
+	nthread = NTHREAD;
+	nitem = NITEM;
+	items = calloc(nitem, sizeof(*items));
+	assert(items != NULL);
+	if(mqinit(&mq, itemcmp, nthread) == NULL) {
+		perror("mqinit");
+		exit(1);
+	}
+	pthread_barrier_init(&start, NULL, nthread);
+	for(i = 0; i < nthread; i++)
+		pthread_create(&thr[i], NULL, stress, (void*)(intptr_t)i);
+	for(i = 0; i < nthread; i++)
+		pthread_join(thr[i], NULL);
+	pthread_barrier_destroy(&start);
+
+	assert(mqdeletemin(&mq) == NULL);
+	for(i = 0; i < nitem; i++)
+		assert(atomic_load(&items[i].out) == 1);
+	printf("Stress test %d threads %d nodes ok\n", nthread, nitem);
+
+	// Single threaded the sub-heaps must stay ordered throughout.
+	for(i = 0; i < nitem; i++) {
+		atomic_store(&items[i].key, (i*7919) % 1000);
+		mqinsert(&mq, &items[i].m);
+		if(i % 1000 == 0) {
+			mqdeletemin(&mq);
+			mqdeletemin(&mq);
+		}
+	}
+	for(i = 0; i < mq.nq; i++) {
+		if(mq.q[i].min != NULL)
+			checktree(mq.q[i].min);
+	}
+	while(mqdeletemin(&mq) != NULL)
+		;
+	mqfree(&mq);
+	free(items);
+	printf("Heap order ok\n");
+}
+
+void*
+hold(void *arg)
+{
+	Mqnode *n;
+	Item *ip;
+	uint64_t x;
+	int i;
+
+	x = (intptr_t)arg*7919 + 1;
+	pthread_barrier_wait(&start);
+	for(i = 0; i < NHOLD/nthread; i++) {
+		if((n = mqdeletemin(&mq)) == NULL)
+			continue;
+		ip = (Item*)n;
+		atomic_store_explicit(&ip->key, ip->key + rnd(&x) % 1024, memory_order_relaxed);
+		mqinsert(&mq, n);
+	}
+	pthread_barrier_wait(&start);
+	return NULL;
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+bench(void)
+{
+	pthread_t thr[64];
+	double t;
+	uint64_t x;
+	long ncpu;
+	int i;
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if(ncpu < 1) ncpu = 1;
+	nitem = NPREFILL;
+	items = calloc(nitem, sizeof(*items));
+	assert(items != NULL);
+	printf("%ld cpus, %d nodes, %d operations\n", ncpu, nitem, NHOLD);
+	for(nthread = 1; nthread <= 2*ncpu && nthread <= 64; nthread *= 2) {
+		if(mqinit(&mq, itemcmp, nthread) == NULL) {
+			perror("mqinit");
+			exit(1);
+		}
+		x = 1;
+		for(i = 0; i < nitem; i++) {
+			atomic_store(&items[i].key, rnd(&x) % (1<<20));
+			mqinsert(&mq, &items[i].m);
+		}
+		pthread_barrier_init(&start, NULL, nthread+1);
+		for(i = 0; i < nthread; i++)
+			pthread_create(&thr[i], NULL, hold, (void*)(intptr_t)i);
+		pthread_barrier_wait(&start);
+		t = now();
+		pthread_barrier_wait(&start);
+		t = now() - t;
+		for(i = 0; i < nthread; i++)
+			pthread_join(thr[i], NULL);
+		pthread_barrier_destroy(&start);
+		printf("threads %2d  %8.2f Mops/s\n", nthread, 2.0*NHOLD/t/1e6);
+		mqfree(&mq);
+	}
+	free(items);
+}
+
+int
+main(int argc, char **argv)
+{
+	if(argc > 1 && strcmp(argv[1], "-b") == 0)
+		bench();
+	else
+		stresstest();
+	return 0;
+}
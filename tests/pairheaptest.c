@@ -0,0 +1,125 @@
+#define _XOPEN_SOURCE
+
+#define BSP_PAIRHEAP_IMPLEMENTATION
+#include "../bsppairheap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct Int Int;
+struct Int {
+	Pairnode p;
+	int i;
+};
+
+int
+intcmp(Pairnode *x, Pairnode *y)
+{
+	Int *s, *t;
+
+	s = (Int*)x;
+	t = (Int*)y;
+
+	if(s->i < t->i)
+		return -1;
+	if(s->i > t->i)
+		return 1;
+	return 0;
+}
+
+enum {
+	POOLSIZ = 100,
+	RANDSIZ = 500,
+};
+
+// Check heap order and the sibling back pointers.
+void
+checktree(Pairnode *n)
+{
+	Pairnode *c, *prev;
+
+	prev = n;
+	for(c = n->c; c != NULL; c = c->next) {
+		assert(c->prev == prev);
+		assert(intcmp(n, c) <= 0);
+		checktree(c);
+		prev = c;
+	}
+}
+
+int
+main(void)
+{
+	Pairheap ph, ph2;
+	Int pool[POOLSIZ], *ip;
+
+	srand48(time(NULL));
+
+	pairinit(&ph, intcmp);
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		printf("Adding %d %p\n", ip->i, (void*)ip);
+		pairinsert(&ph, &ip->p);
+	}
+
+	while(ph.min != NULL) {
+		ip = (Int*)ph.min;
+		printf("Heap sorted %d %p\n", ip->i, (void*)ip);
+		pairdeletemin(&ph);
+		if(ph.min != NULL)
+			checktree(ph.min);
+	}
+
+	printf("\nDecrease key test\n");
+
+	pairinit(&ph, intcmp);
+	for(ip = pool; ip < pool+10; ip++) {
+		ip->i = ip-pool + 10;
+		pairinsert(&ph, &ip->p);
+	}
+
+	ip = pool+4;
+	ip->i = 4;
+	pairdecreasekey(&ph, &ip->p);
+
+	ip = (Int*)ph.min;
+	printf("%d %p\n", ip->i, (void*)ip);
+	pairdeletemin(&ph);
+
+	ip = pool+7;
+	ip->i = 7;
+	pairdecreasekey(&ph, &ip->p);
+	ip = pool+6;
+	ip->i = 6;
+	pairdecreasekey(&ph, &ip->p);
+	checktree(ph.min);
+
+	pairdelete(&ph, &pool[8].p);
+	checktree(ph.min);
+
+	while(ph.min != NULL) {
+		ip = (Int*)ph.min;
+		printf("%d %p\n", ip->i, (void*)ip);
+		pairdeletemin(&ph);
+	}
+
+	printf("\nMeld test\n");
+
+	pairinit(&ph, intcmp);
+	pairinit(&ph2, intcmp);
+	for(ip = pool; ip < pool+10; ip++) {
+		ip->i = drand48()*RANDSIZ;
+		pairinsert(ip-pool < 5 ? &ph : &ph2, &ip->p);
+	}
+	pairmeld(&ph, &ph2);
+	assert(ph2.min == NULL);
+	while(ph.min != NULL) {
+		ip = (Int*)ph.min;
+		printf("%d\n", ip->i);
+		pairdeletemin(&ph);
+	}
+
+	exit(0);
+}
@@ -0,0 +1,287 @@
+/*
+ * Test for bsppath.h.
+ *
+ * On a grid with random weights of at least 1 between neighbours and
+ * on a random directed graph it checks the lengths found by pathbidir
+ * and pathastar against a plain Dijkstra over the whole graph, checks
+ * that the routes are paths of that length, and prints how many nodes
+ * each search settled on average. Then it answers thousands of short
+ * queries on the grid with one Pathfinder, across the wrap of its
+ * search number, and prints the time each took.
+ */
+#define BSP_FIBHEAP_IMPLEMENTATION
+#include "../bspfibheap.h"
+#define BSP_GRAPH_IMPLEMENTATION
+#include "../bspgraph.h"
+#define BSP_PATH_IMPLEMENTATION
+#include "../bsppath.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define nelem(x) (sizeof(x)/sizeof((x)[0]))
+
+enum {
+	W = 200,
+	H = 200,
+	MAXW = 10,
+	NQUERY = 200,
+	NRANDNODE = 5000,
+	NRANDEDGE = 25000,
+	NLOCAL = 20000,
+	LOCAL = 10,
+};
+
+typedef struct Node Node;
+struct Node {
+	Fibnode fib;
+	long long dist;
+};
+
+uint64_t rngstate = 88172645463325252ull;
+
+int
+rnd(int n)
+{
+	rngstate ^= rngstate << 13;
+	rngstate ^= rngstate >> 7;
+	rngstate ^= rngstate << 17;
+	return rngstate % n;
+}
+
+int
+nodecmp(Fibnode *a, Fibnode *b)
+{
+	Node *m, *n;
+
+	m = (Node*)a;
+	n = (Node*)b;
+	if(m->dist < n->dist)
+		return -1;
+	if(m->dist > n->dist)
+		return 1;
+	return 0;
+}
+
+// Distances from s to every node, -1 where unreachable.
+void
+dijkstra(Graph *g, int s, long long *out)
+{
+	Fibheap h;
+	Node *nodes, *n, *m;
+	Grapharc *a;
+	int i;
+
+	nodes = calloc(g->nnodes, sizeof(*nodes));
+	assert(nodes != NULL);
+	for(i = 0; i < g->nnodes; i++)
+		nodes[i].dist = -1;
+	fibinit(&h, nodecmp);
+	nodes[s].dist = 0;
+	fibinsert(&h, &nodes[s].fib);
+	while((n = (Node*)h.min) != NULL) {
+		assert(fibdeletemin(&h) == 0);
+		i = n - nodes;
+		for(a = g->arcs + g->off[i]; a < g->arcs + g->off[i+1]; a++) {
+			m = nodes + a->d;
+			if(m->dist < 0) {
+				m->dist = n->dist + a->w;
+				fibinsert(&h, &m->fib);
+			} else if(m->dist > n->dist + a->w) {
+				m->dist = n->dist + a->w;
+				fibdecreasekey(&h, &m->fib);
+			}
+		}
+	}
+	for(i = 0; i < g->nnodes; i++)
+		out[i] = nodes[i].dist;
+	fibfree(&h);
+	free(nodes);
+}
+
+// Manhattan distance to the target on the grid, each step costing at least 1.
+long long
+manhattan(int v, void *aux)
+{
+	int t;
+
+	t = *(int*)aux;
+	return abs(v%W - t%W) + abs(v/W - t/W);
+}
+
+long long
+zero(int v, void *aux)
+{
+	(void)v;
+	(void)aux;
+	return 0;
+}
+
+// The weight of the lightest arc from u to v.
+long long
+arcweight(Graph *g, int u, int v)
+{
+	Grapharc *a;
+	long long w;
+
+	w = -1;
+	for(a = g->arcs + g->off[u]; a < g->arcs + g->off[u+1]; a++) {
+		if(a->d == v && (w < 0 || a->w < w))
+			w = a->w;
+	}
+	return w;
+}
+
+void
+checkroute(Pathfinder *pf, Graph *g, int s, int t, long long want)
+{
+	static int route[W*H];
+	long long sum, w;
+	int n, i;
+
+	n = pathroute(pf, route, nelem(route));
+	if(want < 0) {
+		assert(n == 0);
+		return;
+	}
+	assert(n > 0 && n <= (int)nelem(route));
+	assert(route[0] == s && route[n-1] == t);
+	sum = 0;
+	for(i = 1; i < n; i++) {
+		w = arcweight(g, route[i-1], route[i]);
+		assert(w >= 0);
+		sum += w;
+	}
+	assert(sum == want);
+}
+
+void
+queries(char *name, Graph *g, Graph *rev, int grid)
+{
+	Pathfinder pf;
+	long long *ref, d;
+	long nbidir, nastar, ndijk;
+	int q, s, t, v, n;
+
+	ref = malloc(g->nnodes * sizeof(*ref));
+	assert(ref != NULL);
+	assert(pathinit(&pf, g, rev) != NULL);
+	nbidir = nastar = ndijk = 0;
+	for(q = 0; q < NQUERY; q++) {
+		s = rnd(g->nnodes);
+		t = q == 0 ? s : rnd(g->nnodes);
+		dijkstra(g, s, ref);
+
+		d = pathbidir(&pf, s, t);
+		assert(d == ref[t]);
+		checkroute(&pf, g, s, t, ref[t]);
+		nbidir += pf.nsettled;
+
+		d = pathastar(&pf, s, t, zero, NULL);
+		assert(d == ref[t]);
+		checkroute(&pf, g, s, t, ref[t]);
+		ndijk += pf.nsettled;
+
+		if(grid) {
+			d = pathastar(&pf, s, t, manhattan, &t);
+			assert(d == ref[t]);
+			checkroute(&pf, g, s, t, ref[t]);
+			nastar += pf.nsettled;
+		}
+
+		if(q%10 == 0) {
+			n = pathfrom(&pf, s);
+			assert(n > 0);
+			for(v = 0; v < g->nnodes; v++) {
+				assert(pathdist(&pf, v) == ref[v]);
+				n -= ref[v] >= 0;
+			}
+			assert(n == 0);
+		}
+	}
+	printf("%s: %d nodes, settled per query: dijkstra %ld bidirectional %ld",
+		name, g->nnodes, ndijk/NQUERY, nbidir/NQUERY);
+	if(grid)
+		printf(" a* %ld", nastar/NQUERY);
+	printf("\n");
+	pathfree(&pf);
+	free(ref);
+}
+
+// Queries between nearby cells of the grid, which should touch few nodes.
+void
+localqueries(Graph *g)
+{
+	Pathfinder pf;
+	long long d;
+	long nsettled;
+	clock_t start;
+	int q, s, t;
+
+	assert(pathinit(&pf, g, g) != NULL);
+	pf.epoch = UINT_MAX - NLOCAL/2;
+	nsettled = 0;
+	start = clock();
+	for(q = 0; q < NLOCAL; q++) {
+		s = rnd(W-LOCAL) + rnd(H-LOCAL)*W;
+		t = s + rnd(LOCAL) + rnd(LOCAL)*W;
+		d = pathbidir(&pf, s, t);
+		assert(d >= 0);
+		nsettled += pf.nsettled;
+		assert(pathastar(&pf, s, t, manhattan, &t) == d);
+		assert(pathdist(&pf, t) == d);
+		nsettled += pf.nsettled;
+	}
+	printf("local: %d queries, settled per query %ld, %.2f us per query\n",
+		2*NLOCAL, nsettled/(2*NLOCAL),
+		(double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / (2*NLOCAL));
+	pathfree(&pf);
+}
+
+int
+main(void)
+{
+	Graphedge *edges, *e;
+	Graph g, rev;
+	int x, y, n, i;
+
+	// A grid with an edge to the right and below each cell.
+	edges = calloc(2*W*H, sizeof(*edges));
+	assert(edges != NULL);
+	e = edges;
+	for(y = 0; y < H; y++) {
+		for(x = 0; x < W; x++) {
+			if(x+1 < W)
+				*e++ = (Graphedge){y*W + x, y*W + x+1, 1 + rnd(MAXW)};
+			if(y+1 < H)
+				*e++ = (Graphedge){y*W + x, (y+1)*W + x, 1 + rnd(MAXW)};
+		}
+	}
+	assert(graphbuild(&g, W*H, edges, e - edges, GRAPHUNDIRECTED) != NULL);
+	queries("grid", &g, &g, 1);
+	localqueries(&g);
+	graphfree(&g);
+	free(edges);
+
+	// A sparse random directed graph, so the backward search needs rev.
+	edges = calloc(NRANDEDGE, sizeof(*edges));
+	assert(edges != NULL);
+	for(i = 0; i < NRANDEDGE; i++)
+		edges[i] = (Graphedge){rnd(NRANDNODE), rnd(NRANDNODE), rnd(1000)};
+	assert(graphbuild(&g, NRANDNODE, edges, NRANDEDGE, 0) != NULL);
+	for(i = 0; i < NRANDEDGE; i++) {
+		n = edges[i].s;
+		edges[i].s = edges[i].d;
+		edges[i].d = n;
+	}
+	assert(graphbuild(&rev, NRANDNODE, edges, NRANDEDGE, 0) != NULL);
+	queries("directed", &g, &rev, 0);
+	graphfree(&g);
+	graphfree(&rev);
+	free(edges);
+	return 0;
+}
@@ -0,0 +1,394 @@
+/*
+ * Benchmark of the priority queues over generated graphs, run by
+ * make bench from this directory.
+ *
+ *	pqbench [-n nodes] [-m edges] [-w min,max] [-t type] [-r reps]
+ *
+ * For each type of graph, random, grid and power unless -t names one,
+ * it has graphgen write an input for dijkstra.c and one for prim.c and
+ * runs every heap variant of both on them with -c, keeping the fastest
+ * of reps runs. It prints a header and then one tab separated line per
+ * variant and graph with
+ *
+ *	prog type nodes edges wall_s solve_ns ops ns_per_op cmp maxrss_kb
+ *	cycles instructions cache_misses out
+ *
+ * where solve_ns, ops and cmp are the time in the algorithm alone and
+ * the heap operations and comparisons it made, as the program reports
+ * them, and ns_per_op is solve_ns/ops. Wall_s, maxrss_kb and the
+ * counters cover the whole process, reading the input included. The
+ * counters come from perf_event_open on Linux and are - where it is
+ * not allowed. Cmp comes from one more run of a build of the program
+ * with -DCOUNTCMP, named with count appended, since a counter in the
+ * comparison would slow the timed runs. It is - for the radix heap,
+ * which does not compare. Out is a hash of the output of the program,
+ * which must be the same for every variant.
+ */
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#define nelem(x) (sizeof(x)/sizeof((x)[0]))
+
+enum {
+	NCTR = 3,
+};
+
+typedef struct Run Run;
+struct Run {
+	double wall;
+	long long ns;
+	long ops;
+	char cmp[32];
+	long maxrss;
+	long long ctr[NCTR];
+	uint32_t out;
+};
+
+// Count is the build of name that counts comparisons, if it makes any.
+typedef struct Prog Prog;
+struct Prog {
+	char *name;
+	char *count;
+	int prim;
+};
+
+Prog progs[] = {
+	{"dijkstra", "dijkstracount", 0},
+	{"dijkstrainline", "dijkstrainlinecount", 0},
+	{"dijkstrafib32", "dijkstrafib32count", 0},
+	{"dijkstrapair", "dijkstrapaircount", 0},
+	{"dijkstradary", "dijkstradarycount", 0},
+	{"dijkstraradix", NULL, 0},
+	{"prim", "primcount", 1},
+	{"primpair", "primpaircount", 1},
+	{"primdary", "primdarycount", 1},
+};
+
+char *types[] = {"random", "grid", "power"};
+
+void
+sysfatal(char *fmt, ...)
+{
+	char buf[1024];
+	int w;
+	va_list va;
+
+	w = snprintf(buf, sizeof(buf), "pqbench: ");
+	va_start(va, fmt);
+	w += vsnprintf(buf+w, sizeof(buf)-w, fmt, va);
+	va_end(va);
+	snprintf(buf+w, sizeof(buf)-w, ": %s", strerror(errno));
+
+	fprintf(stderr, "%s\n", buf);
+	exit(1);
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+#ifdef __linux__
+int ctrconfig[NCTR] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+};
+
+// A counter of pid's user time work from its exec on, or -1.
+int
+ctropen(pid_t pid, int config)
+{
+	struct perf_event_attr pe;
+
+	memset(&pe, 0, sizeof(pe));
+	pe.type = PERF_TYPE_HARDWARE;
+	pe.size = sizeof(pe);
+	pe.config = config;
+	pe.disabled = 1;
+	pe.enable_on_exec = 1;
+	pe.inherit = 1;
+	pe.exclude_kernel = 1;
+	pe.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &pe, pid, -1, -1, 0);
+}
+#endif
+
+/*
+ * Run argv with the files in, out and err as its standard ones, the
+ * child waiting for a byte on go before it execs.
+ */
+pid_t
+spawn(char **argv, int in, int out, int err, int go)
+{
+	pid_t pid;
+	char c;
+
+	pid = fork();
+	if(pid < 0)
+		sysfatal("fork");
+	if(pid > 0)
+		return pid;
+	dup2(in, 0);
+	dup2(out, 1);
+	dup2(err, 2);
+	if(go >= 0 && read(go, &c, 1) != 1)
+		_exit(127);
+	execv(argv[0], argv);
+	_exit(127);
+}
+
+// The FNV-1a hash of everything read from fd.
+uint32_t
+hashfd(int fd)
+{
+	unsigned char buf[65536];
+	uint32_t h;
+	ssize_t n, i;
+
+	h = 2166136261u;
+	while((n = read(fd, buf, sizeof(buf))) > 0) {
+		for(i = 0; i < n; i++)
+			h = (h ^ buf[i]) * 16777619u;
+	}
+	return h;
+}
+
+void
+run(char *prog, char *input, Run *r)
+{
+	char path[64], err[256], *argv[3];
+	int in, out[2], errp[2], go[2], ctr[NCTR], status, i;
+	struct rusage ru;
+	ssize_t n;
+	pid_t pid;
+	double t;
+
+	snprintf(path, sizeof(path), "./%s", prog);
+	argv[0] = path;
+	argv[1] = "-c";
+	argv[2] = NULL;
+	if((in = open(input, O_RDONLY)) < 0)
+		sysfatal("open %s", input);
+	if(pipe(out) < 0 || pipe(errp) < 0 || pipe(go) < 0)
+		sysfatal("pipe");
+	// Only the copies spawn makes on 0, 1 and 2 survive the exec.
+	for(i = 0; i < 2; i++) {
+		fcntl(out[i], F_SETFD, FD_CLOEXEC);
+		fcntl(errp[i], F_SETFD, FD_CLOEXEC);
+		fcntl(go[i], F_SETFD, FD_CLOEXEC);
+	}
+	pid = spawn(argv, in, out[1], errp[1], go[0]);
+	close(in);
+	close(out[1]);
+	close(errp[1]);
+	close(go[0]);
+
+	for(i = 0; i < NCTR; i++) {
+#ifdef __linux__
+		ctr[i] = ctropen(pid, ctrconfig[i]);
+#else
+		ctr[i] = -1;
+#endif
+	}
+	t = now();
+	if(write(go[1], "", 1) != 1)
+		sysfatal("write");
+	close(go[1]);
+
+	// The statistics line is short enough to wait in the pipe.
+	r->out = hashfd(out[0]);
+	n = read(errp[0], err, sizeof(err)-1);
+	err[n > 0 ? n : 0] = '\0';
+	close(out[0]);
+	close(errp[0]);
+	if(wait4(pid, &status, 0, &ru) < 0)
+		sysfatal("wait4");
+	r->wall = now() - t;
+	if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		sysfatal("%s failed: %s", prog, err);
+	if(sscanf(err, "ns %lld ops %ld cmp %31s", &r->ns, &r->ops, r->cmp) != 3)
+		sysfatal("%s printed no statistics: %s", prog, err);
+	r->maxrss = ru.ru_maxrss;
+
+	for(i = 0; i < NCTR; i++) {
+		r->ctr[i] = -1;
+		if(ctr[i] < 0)
+			continue;
+		if(read(ctr[i], &r->ctr[i], sizeof(r->ctr[i])) != sizeof(r->ctr[i]))
+			r->ctr[i] = -1;
+		close(ctr[i]);
+	}
+}
+
+void
+gen(char *file, char *type, char *n, char *m, char *w, int prim)
+{
+	char *argv[16];
+	int out, status, i;
+	pid_t pid;
+
+	i = 0;
+	argv[i++] = "./graphgen";
+	if(prim)
+		argv[i++] = "-p";
+	argv[i++] = "-t";
+	argv[i++] = type;
+	argv[i++] = "-n";
+	argv[i++] = n;
+	argv[i++] = "-m";
+	argv[i++] = m;
+	argv[i++] = "-w";
+	argv[i++] = w;
+	argv[i] = NULL;
+	if((out = open(file, O_WRONLY|O_TRUNC)) < 0)
+		sysfatal("open %s", file);
+	pid = spawn(argv, 0, out, 2, -1);
+	close(out);
+	if(waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		sysfatal("graphgen failed");
+}
+
+// The node and edge counts graphgen wrote at the top of file.
+void
+graphsize(char *file, int prim, int *n, int *m)
+{
+	FILE *f;
+	int cases;
+
+	if((f = fopen(file, "r")) == NULL)
+		sysfatal("open %s", file);
+	if((!prim && fscanf(f, "%d", &cases) != 1) || fscanf(f, "%d %d", n, m) != 2)
+		sysfatal("%s: bad graph", file);
+	fclose(f);
+}
+
+void
+printctr(long long c)
+{
+	if(c < 0)
+		printf("\t-");
+	else
+		printf("\t%lld", c);
+}
+
+void
+usage(void)
+{
+	fprintf(stderr, "usage: pqbench [-n nodes] [-m edges] [-w min,max] [-t type] [-r reps]\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	char dfile[] = "/tmp/pqbenchXXXXXX", pfile[] = "/tmp/pqbenchXXXXXX";
+	char *n, *m, *w, *type, *file;
+	uint32_t want[2];
+	Run best, r;
+	Prog *p;
+	int reps, nnodes, nedges, fd, t, i;
+
+	n = "100000";
+	m = "1000000";
+	w = "1,100000";
+	type = NULL;
+	reps = 1;
+	for(i = 1; i < argc; i++) {
+		if(argv[i][0] != '-' || i+1 == argc)
+			usage();
+		switch(argv[i++][1]) {
+		case 'n':
+			n = argv[i];
+			break;
+		case 'm':
+			m = argv[i];
+			break;
+		case 'w':
+			w = argv[i];
+			break;
+		case 't':
+			type = argv[i];
+			break;
+		case 'r':
+			reps = atoi(argv[i]);
+			break;
+		default:
+			usage();
+		}
+	}
+	if(reps < 1)
+		usage();
+	for(t = 0; type != NULL && t < (int)nelem(types); t++) {
+		if(strcmp(type, types[t]) == 0)
+			break;
+	}
+	if(t == nelem(types))
+		usage();
+
+	if((fd = mkstemp(dfile)) < 0)
+		sysfatal("mkstemp");
+	close(fd);
+	if((fd = mkstemp(pfile)) < 0)
+		sysfatal("mkstemp");
+	close(fd);
+
+	printf("prog\ttype\tnodes\tedges\twall_s\tsolve_ns\tops\tns_per_op\tcmp\tmaxrss_kb\tcycles\tinstructions\tcache_misses\tout\n");
+	for(t = 0; t < (int)nelem(types); t++) {
+		if(type != NULL && strcmp(type, types[t]) != 0)
+			continue;
+		gen(dfile, types[t], n, m, w, 0);
+		gen(pfile, types[t], n, m, w, 1);
+		want[0] = want[1] = 0;
+		for(p = progs; p < progs + nelem(progs); p++) {
+			file = p->prim ? pfile : dfile;
+			for(i = 0; i < reps; i++) {
+				run(p->name, file, &r);
+				if(i == 0 || r.ns < best.ns)
+					best = r;
+			}
+			if(p->count != NULL) {
+				run(p->count, file, &r);
+				if(r.out != best.out)
+					fprintf(stderr, "pqbench: %s on %s: output differs\n", p->count, types[t]);
+				memcpy(best.cmp, r.cmp, sizeof(best.cmp));
+			}
+			if(want[p->prim] == 0)
+				want[p->prim] = best.out;
+			else if(best.out != want[p->prim])
+				fprintf(stderr, "pqbench: %s on %s: output differs\n", p->name, types[t]);
+			graphsize(file, p->prim, &nnodes, &nedges);
+			printf("%s\t%s\t%d\t%d\t%.3f\t%lld\t%ld\t%.1f\t%s\t%ld",
+				p->name, types[t], nnodes, nedges, best.wall, best.ns, best.ops,
+				best.ops > 0 ? (double)best.ns/best.ops : 0.0, best.cmp, best.maxrss);
+			for(i = 0; i < NCTR; i++)
+				printctr(best.ctr[i]);
+			printf("\t%08x\n", best.out);
+			fflush(stdout);
+		}
+	}
+	unlink(dfile);
+	unlink(pfile);
+	return 0;
+}
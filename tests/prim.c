@@ -2,14 +2,58 @@
 // The implementation of the Prim algorithm is the function prim. Everything else
 // is setup.
 
+// The priority queue is a Fibonacci heap unless PAIRHEAP or DARYHEAP
+// is defined. With -c the time spent in prim and the heap operations it
+// made are printed to stderr at the end for tests/pqbench.c, with the
+// comparisons of arcs if COUNTCMP is defined and - otherwise.
+#define _POSIX_C_SOURCE 200809L
+
+#if defined(PAIRHEAP)
+#define BSP_PAIRHEAP_IMPLEMENTATION
+#include "../bsppairheap.h"
+
+typedef Pairheap Heap;
+typedef Pairnode Heapnode;
+#define heapinit pairinit
+#define heapinsert pairinsert
+#define heapdeletemin(h) (pairdeletemin(h), 0)
+#define heapdecreasekey pairdecreasekey
+#define heapfree(h)
+#elif defined(DARYHEAP)
+#define BSP_DARYHEAP_IMPLEMENTATION
+#include "../bspdaryheap.h"
+
+typedef Daryheap Heap;
+typedef Darynode Heapnode;
+#define heapinit daryinit
+#define heapinsert(h, n) (daryinsert(h, n) < 0 ? sysfatal("insertion failed") : (void)0)
+#define heapdeletemin(h) (darydeletemin(h), 0)
+#define heapdecreasekey darydecreasekey
+#define heapfree daryfree
+#else
 #define BSP_FIBHEAP_IMPLEMENTATION
 #include "../bspfibheap.h"
 
+typedef Fibheap Heap;
+typedef Fibnode Heapnode;
+#define heapinit fibinit
+#define heapinsert fibinsert
+#define heapdeletemin fibdeletemin
+#define heapdecreasekey fibdecreasekey
+#define heapfree fibfree
+#endif
+
+#define BSP_GRAPH_IMPLEMENTATION
+#include "../bspgraph.h"
+#define BSP_INTREAD_IMPLEMENTATION
+#include "../bspintread.h"
+
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 void
 sysfatal(char *fmt, ...)
@@ -28,157 +72,140 @@ sysfatal(char *fmt, ...)
 	exit(1);
 }
 
-typedef struct Edge Edge;
-typedef struct Node Node;
+Intreader in;
 
-struct Edge {
-	Fibnode fibnode;
-	Edge *next;
-	Node *node;
-	int dist;
-};
-
-struct Node {
-	Edge *edges, **etail;
-	int intree;
-};
+int
+getint(void)
+{
+	int v;
 
-struct {
-	Node *a;
-	int len;
-} nodes;
+	if(!intread(&in, &v))
+		sysfatal("unexpected end of input");
+	return v;
+}
 
-Edge *edgepool;
+int cflag;
+long long nsolve;
+long nops, ncmp;
 
-Edge*
-edgealloc(void)
+long long
+nsec(void)
 {
-	Edge *e;
+	struct timespec ts;
 
-	if(edgepool == NULL)
-		return malloc(sizeof(Edge));
-
-	e = edgepool;
-	edgepool = edgepool->next;
-	return e;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000LL + ts.tv_nsec;
 }
 
-Node*
-nodedata(int n)
-{
-	return nodes.a + n-1;
-}
+struct {
+	Graphedge *a;
+	int len;
+} edges;
+
+Graph graph;
+
+// The heap node of graph.arcs[i] is arcnodes[i].
+Heapnode *arcnodes;
+char *intree;
 
 int
-edgecmp(Fibnode *a, Fibnode *b)
+arccmp(Heapnode *a, Heapnode *b)
 {
-	Edge *e, *f;
+	Grapharc *e, *f;
 
-	e = (Edge*)a;
-	f = (Edge*)b;
+	e = graph.arcs + (a - arcnodes);
+	f = graph.arcs + (b - arcnodes);
+#ifdef COUNTCMP
+	ncmp++;
+#endif
 
-	if(e->dist < f->dist)
+	if(e->w < f->w)
 		return -1;
-	if(e->dist > f->dist)
+	if(e->w > f->w)
 		return 1;
 	return 0;
 }
 
 void
-addedge(int s, int d, int dist)
+insertarcs(Heap *pq, int n)
 {
-	Edge *e;
-	Node *n;
-
-	e = edgealloc();
-	e->node = nodedata(d);
-	e->dist = dist;
-	e->next = NULL;
-	n = nodedata(s);
-	*n->etail = e;
-	n->etail = &e->next;
-}
-
-void
-initnodedata(Node *n)
-{
-	*n->etail = edgepool;
-	edgepool = n->edges;
-	n->edges = NULL;
-	n->etail = &n->edges;
-	n->intree = 0;
-}
-
-void
-reallocnodes(int nnodes)
-{
-	Node *ni;
+	int i;
 
-	nodes.len = 2*nnodes;
-	free(nodes.a);
-	nodes.a = calloc(nodes.len, sizeof(*nodes.a));
-	for(ni = nodes.a; ni < nodes.a+nodes.len; ni++)
-		ni->etail = &ni->edges;
-}
-
-void
-insertedges(Fibheap *pq, Node *s)
-{
-	Edge *e;
-
-	for(e = s->edges; e != NULL; e = e->next) {
-		if(e->node->intree)
+	for(i = graph.off[n]; i < graph.off[n+1]; i++) {
+		if(intree[graph.arcs[i].d])
 			continue;
-		fibinsert(pq, &e->fibnode);
+		heapinsert(pq, &arcnodes[i]);
+		nops++;
 	}
 }
 
 int
 prim(int start)
 {
-	Fibheap pq;
-	Node *n;
-	Edge *e;
-	int primsum;
-
-	fibinit(&pq, edgecmp);
-	n = nodedata(start);
-	n->intree = 1;
+	Heap pq;
+	Grapharc *a;
+	long long t;
+	int primsum, n;
+
+	t = nsec();
+	heapinit(&pq, arccmp);
+	n = start-1;
+	intree[n] = 1;
 	primsum = 0;
-	insertedges(&pq, n);
+	insertarcs(&pq, n);
 	while(pq.min != NULL) {
-		e = (Edge*)pq.min;
-		if(fibdeletemin(&pq) < 0)
+		a = graph.arcs + (pq.min - arcnodes);
+		if(heapdeletemin(&pq) < 0)
 			sysfatal("deletion failed");
-		n = e->node;
-		if(n->intree)
+		nops++;
+		n = a->d;
+		if(intree[n])
 			continue;
-		n->intree = 1;
-		primsum += e->dist;
-		insertedges(&pq, n);
+		intree[n] = 1;
+		primsum += a->w;
+		insertarcs(&pq, n);
 	}
-	fibfree(&pq);
+	heapfree(&pq);
+	nsolve = nsec() - t;
 	return primsum;
 }
 
 int
-main(void)
+main(int argc, char **argv)
 {
-	Node *ni;
-	int nnodes, edges, s, d, dist, start;
-
-	scanf("%d %d", &nnodes, &edges);
-	if(nodes.len < nnodes)
-		reallocnodes(nnodes);
-	for(ni = nodes.a; ni < nodes.a+nnodes; ni++)
-		initnodedata(ni);
-
-	while(edges-- > 0) {
-		scanf("%d %d %d", &s, &d, &dist);
-		addedge(s, d, dist);
-		addedge(d, s, dist);
+	Graphedge *e;
+	int nnodes, nedges, start;
+
+	if(argc > 1 && strcmp(argv[1], "-c") == 0)
+		cflag = 1;
+	if(intreaderinit(&in, 0) == NULL)
+		sysfatal("reading input");
+	nnodes = getint();
+	nedges = getint();
+	edges.len = nedges;
+	edges.a = calloc(nedges, sizeof(*edges.a));
+	if(edges.a == NULL)
+		sysfatal("calloc");
+	for(e = edges.a; e < edges.a + nedges; e++) {
+		e->s = getint() - 1;
+		e->d = getint() - 1;
+		e->w = getint();
 	}
 
-	scanf("%d", &start);
+	if(graphbuild(&graph, nnodes, edges.a, nedges, GRAPHUNDIRECTED) == NULL)
+		sysfatal("graphbuild");
+	arcnodes = calloc(graph.narcs, sizeof(*arcnodes));
+	intree = calloc(nnodes, 1);
+	if(arcnodes == NULL || intree == NULL)
+		sysfatal("calloc");
+
+	start = getint();
 	printf("%d\n", prim(start));
+	if(cflag) {
+#ifdef COUNTCMP
+		fprintf(stderr, "ns %lld ops %ld cmp %ld\n", nsolve, nops, ncmp);
+#else
+		fprintf(stderr, "ns %lld ops %ld cmp -\n", nsolve, nops);
+#endif
+	}
 }
@@ -0,0 +1,82 @@
+#define _XOPEN_SOURCE
+
+#define BSP_RADIXHEAP_IMPLEMENTATION
+#include "../bspradixheap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct Int Int;
+struct Int {
+	Radixnode r;
+	int inheap;
+};
+
+enum {
+	POOLSIZ = 100,
+	RANDSIZ = 500,
+};
+
+int
+main(void)
+{
+	Radixheap rh;
+	Int pool[POOLSIZ], *ip, *jp;
+	uint64_t last, k;
+	int i;
+
+	srand48(time(NULL));
+
+	radixinit(&rh);
+	for(ip = pool; ip < pool+POOLSIZ; ip++) {
+		radixinsert(&rh, &ip->r, drand48()*RANDSIZ);
+		printf("Adding %d %p\n", (int)ip->r.key, (void*)ip);
+	}
+
+	last = 0;
+	while((ip = (Int*)radixdeletemin(&rh)) != NULL) {
+		printf("Heap sorted %d %p\n", (int)ip->r.key, (void*)ip);
+		assert(ip->r.key >= last);
+		last = ip->r.key;
+	}
+
+	printf("\nMonotone test\n");
+
+	// Simulate Dijkstra: keys inserted are never below the last minimum.
+	radixinit(&rh);
+	for(ip = pool; ip < pool+POOLSIZ; ip++)
+		ip->inheap = 0;
+	radixinsert(&rh, &pool[0].r, 0);
+	pool[0].inheap = 1;
+	last = 0;
+	while((ip = (Int*)radixdeletemin(&rh)) != NULL) {
+		assert(ip->r.key >= last);
+		last = ip->r.key;
+		ip->inheap = -1;
+		for(i = 0; i < 5; i++) {
+			jp = pool + (int)(drand48()*POOLSIZ);
+			k = last + drand48()*RANDSIZ;
+			if(jp->inheap == 0) {
+				radixinsert(&rh, &jp->r, k);
+				jp->inheap = 1;
+			} else if(jp->inheap == 1 && k < jp->r.key)
+				radixdecreasekey(&rh, &jp->r, k);
+		}
+	}
+	printf("last key %d\n", (int)last);
+
+	printf("\nDelete test\n");
+
+	radixinit(&rh);
+	for(ip = pool; ip < pool+10; ip++)
+		radixinsert(&rh, &ip->r, ip-pool + 10);
+	radixdelete(&rh, &pool[0].r);
+	radixdecreasekey(&rh, &pool[7].r, 7);
+	radixdelete(&rh, &pool[3].r);
+	while((ip = (Int*)radixdeletemin(&rh)) != NULL)
+		printf("%d %p\n", (int)ip->r.key, (void*)ip);
+
+	exit(0);
+}
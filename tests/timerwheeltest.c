@@ -0,0 +1,277 @@
+/*
+ * Test and benchmark for bsptimerwheel.h.
+ *
+ * Without arguments it adds, cancels and expires random timers with
+ * delays of every magnitude, some already past, while moving the clock
+ * by steps both small and large, and checks every expiry against a
+ * scan of all the timers. It does so once with the clock starting at 0
+ * and once near the end of the 64 bit range.
+ *
+ * With -b it runs a timeout workload where most timers are cancelled
+ * and rescheduled before they expire, once on a Timerwheel and once on
+ * a Fibheap using fibdelete to cancel, and prints the time of each.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#define BSP_TIMERWHEEL_IMPLEMENTATION
+#include "../bsptimerwheel.h"
+#define BSP_FIBHEAP_IMPLEMENTATION
+#include "../bspfibheap.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+	NTIMER = 5000,
+	NROUND = 4000,
+	NCONN = 100000,
+	NTICK = 200000,
+	NACTIVE = 10,
+	TIMEOUT = 10000,
+};
+
+typedef struct Timer Timer;
+struct Timer {
+	Timernode t;
+	uint64_t when;
+	int armed;
+};
+
+typedef struct Conn Conn;
+struct Conn {
+	Fibnode f;
+	uint64_t when;
+};
+
+uint64_t rngstate = 88172645463325252ull;
+
+uint64_t
+rnd(void)
+{
+	rngstate ^= rngstate << 13;
+	rngstate ^= rngstate >> 7;
+	rngstate ^= rngstate << 17;
+	return rngstate;
+}
+
+// A delay of a random number of bits, so every level gets timers.
+uint64_t
+delay(void)
+{
+	int bits;
+
+	bits = rnd() % 48;
+	return rnd() & ((1ull << bits) - 1);
+}
+
+uint64_t
+later(uint64_t now, uint64_t d)
+{
+	return d > UINT64_MAX - now ? UINT64_MAX : now + d;
+}
+
+void
+check(Timerwheel *w, Timer *timers, uint64_t now)
+{
+	Timer *tp;
+	uint64_t min, next;
+
+	min = UINT64_MAX;
+	for(tp = timers; tp < timers + NTIMER; tp++) {
+		if(!tp->armed) continue;
+		assert(tp->when > now);
+		assert(tp->t.when == tp->when);
+		if(tp->when < min) min = tp->when;
+	}
+	next = timernext(w);
+	assert(next <= min);
+	assert(next > now || next == UINT64_MAX);
+}
+
+void
+randomtest(uint64_t start)
+{
+	static Timer timers[NTIMER];
+	Timerwheel w;
+	Timer *tp;
+	uint64_t now;
+	long nfired, ncancel;
+	int r, i;
+
+	memset(timers, 0, sizeof(timers));
+	timerinit(&w, start);
+	now = start;
+	nfired = ncancel = 0;
+	for(r = 0; r < NROUND; r++) {
+		for(i = 0; i < 20; i++) {
+			tp = timers + rnd()%NTIMER;
+			if(tp->armed) {
+				timercancel(&w, &tp->t);
+				tp->armed = 0;
+				ncancel++;
+				// A second cancel must do nothing.
+				timercancel(&w, &tp->t);
+				continue;
+			}
+			if(rnd()%8 == 0 && now > start)
+				tp->when = now - rnd()%(now-start+1);
+			else
+				tp->when = later(now, delay());
+			timeradd(&w, &tp->t, tp->when);
+			tp->armed = 1;
+		}
+
+		switch(rnd()%4) {
+		case 0:
+			now = later(now, 1);
+			break;
+		case 1:
+			now = later(now, rnd()%200);
+			break;
+		default:
+			now = later(now, delay());
+			break;
+		}
+		while((tp = (Timer*)timerexpire(&w, now)) != NULL) {
+			assert(tp->armed);
+			assert(tp->when <= now);
+			tp->armed = 0;
+			nfired++;
+		}
+		check(&w, timers, now);
+	}
+
+	// Run everything left out.
+	while((tp = (Timer*)timerexpire(&w, UINT64_MAX)) != NULL) {
+		assert(tp->armed);
+		tp->armed = 0;
+		nfired++;
+	}
+	assert(timernext(&w) == UINT64_MAX);
+	for(tp = timers; tp < timers + NTIMER; tp++)
+		assert(!tp->armed);
+	printf("start %llu: fired %ld cancelled %ld\n",
+		(unsigned long long)start, nfired, ncancel);
+}
+
+double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+void
+report(char *name, double t, long nops, long nfired)
+{
+	printf("%-10s %8.3f s  %6.1f ns/op  fired %ld\n", name, t, t*1e9/nops, nfired);
+}
+
+// Connections time out after TIMEOUT ticks without activity.
+void
+benchwheel(void)
+{
+	Timerwheel w;
+	Timer *conns, *c;
+	uint64_t tick;
+	long nfired;
+	double t;
+	int i;
+
+	conns = calloc(NCONN, sizeof(*conns));
+	assert(conns != NULL);
+	rngstate = 88172645463325252ull;
+	t = now();
+	timerinit(&w, 0);
+	for(c = conns; c < conns + NCONN; c++)
+		timeradd(&w, &c->t, TIMEOUT + rnd()%TIMEOUT);
+	nfired = 0;
+	for(tick = 1; tick <= NTICK; tick++) {
+		for(i = 0; i < NACTIVE; i++) {
+			c = conns + rnd()%NCONN;
+			timercancel(&w, &c->t);
+			timeradd(&w, &c->t, tick + TIMEOUT);
+		}
+		while((c = (Timer*)timerexpire(&w, tick)) != NULL) {
+			timeradd(&w, &c->t, tick + TIMEOUT);
+			nfired++;
+		}
+	}
+	report("timerwheel", now() - t, (long)NTICK*NACTIVE + nfired, nfired);
+	free(conns);
+}
+
+int
+conncmp(Fibnode *a, Fibnode *b)
+{
+	Conn *x, *y;
+
+	x = (Conn*)a;
+	y = (Conn*)b;
+	if(x->when < y->when) return -1;
+	if(x->when > y->when) return 1;
+	return 0;
+}
+
+void
+benchfib(void)
+{
+	Fibheap h;
+	Conn *conns, *c;
+	uint64_t tick;
+	long nfired;
+	double t;
+	int i;
+
+	conns = calloc(NCONN, sizeof(*conns));
+	assert(conns != NULL);
+	rngstate = 88172645463325252ull;
+	t = now();
+	fibinit(&h, conncmp);
+	for(c = conns; c < conns + NCONN; c++) {
+		c->when = TIMEOUT + rnd()%TIMEOUT;
+		fibinsert(&h, &c->f);
+	}
+	nfired = 0;
+	for(tick = 1; tick <= NTICK; tick++) {
+		for(i = 0; i < NACTIVE; i++) {
+			c = conns + rnd()%NCONN;
+			if(fibdelete(&h, &c->f) < 0) {
+				fprintf(stderr, "fibdelete failed\n");
+				exit(1);
+			}
+			c->when = tick + TIMEOUT;
+			fibinsert(&h, &c->f);
+		}
+		while((c = (Conn*)h.min) != NULL && c->when <= tick) {
+			if(fibdeletemin(&h) < 0) {
+				fprintf(stderr, "fibdeletemin failed\n");
+				exit(1);
+			}
+			c->when = tick + TIMEOUT;
+			fibinsert(&h, &c->f);
+			nfired++;
+		}
+	}
+	report("fibheap", now() - t, (long)NTICK*NACTIVE + nfired, nfired);
+	fibfree(&h);
+	free(conns);
+}
+
+int
+main(int argc, char **argv)
+{
+	if(argc > 1 && strcmp(argv[1], "-b") == 0) {
+		benchwheel();
+		benchfib();
+		return 0;
+	}
+	randomtest(0);
+	randomtest(UINT64_MAX - (1ull << 46));
+	return 0;
+}